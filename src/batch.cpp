@@ -0,0 +1,211 @@
+#include "batch.hpp"
+#include "epd.hpp"
+#include "search.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct BatchOptions {
+        const char* input = "-";
+        int threads = 1;
+        SearchLimits limits;
+        size_t hashMegabytes = 16;
+        bool partitionHash = false;     // One table of hashMegabytes / threads per worker instead of a shared one
+        bool inputOrder = true;         // Otherwise results are written as soon as they are ready
+    };
+
+    // Hands out the input lines to the workers and collects their results
+    class Batch {
+    public:
+        Batch(std::istream& in, std::ostream& out, bool inputOrder) : mIn(in), mOut(out), mInputOrder(inputOrder) {}
+
+        // Returns false at the end of the input
+        bool NextLine(std::string& line, uint64_t& index);
+        void Emit(uint64_t index, const std::string& json);
+
+        uint64_t GetCount() const { return mNextIndex; }
+
+    private:
+        std::istream& mIn;
+        std::mutex mInMutex;
+        uint64_t mNextIndex = 0;
+
+        std::ostream& mOut;
+        std::mutex mOutMutex;
+        bool mInputOrder;
+        uint64_t mNextOutIndex = 0;
+        std::map<uint64_t, std::string> mPending;   // Finished out of order, waiting for earlier lines
+    };
+
+    bool Batch::NextLine(std::string& line, uint64_t& index) {
+        std::lock_guard lock(mInMutex);
+        while (std::getline(mIn, line)) {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            index = mNextIndex++;
+            return true;
+        }
+        return false;
+    }
+
+    void Batch::Emit(uint64_t index, const std::string& json) {
+        std::lock_guard lock(mOutMutex);
+        if (!mInputOrder) {
+            mOut << json << std::endl;
+            return;
+        }
+        mPending.emplace(index, json);
+        for (auto it = mPending.begin(); it != mPending.end() && it->first == mNextOutIndex; it = mPending.erase(it)) {
+            mOut << it->second << '\n';
+            ++mNextOutIndex;
+        }
+        mOut.flush();
+    }
+
+    // Escapes every control character, a raw one would make the line invalid JSON
+    std::string JsonString(std::string_view text) {
+        constexpr char HEX_DIGITS[] = "0123456789abcdef";
+        std::string json = "\"";
+        for (char c : text) {
+            unsigned char byte = c;
+            if (c == '"' || c == '\\')  json += { '\\', c };
+            else if (c == '\t')         json += "\\t";
+            else if (byte < 0x20)       json += { '\\', 'u', '0', '0', HEX_DIGITS[byte >> 4], HEX_DIGITS[byte & 0xF] };
+            else                        json += c;
+        }
+        return json + '"';
+    }
+
+    std::string ResultJson(uint64_t index, const EpdRecord& record, const std::string& fen, const SearchResult& result) {
+        std::ostringstream json;
+        json << "{\"index\":" << index;
+        if (!record.id.empty()) json << ",\"id\":" << JsonString(record.id);
+        json << ",\"fen\":" << JsonString(fen)
+             << ",\"bestmove\":\"" << result.bestMove.ToUCI() << '"'
+             << ",\"score\":{" << (IsMateScore(result.score) ? "\"mate\":" : "\"cp\":")
+             << (IsMateScore(result.score) ? MateInMoves(result.score) : result.score) << '}'
+             << ",\"depth\":" << result.depth
+             << ",\"pv\":[";
+        for (size_t i = 0; i < result.pv.size(); ++i) json << (i ? ",\"" : "\"") << result.pv[i].ToUCI() << '"';
+        json << "],\"nodes\":" << result.nodes
+             << ",\"time_ms\":" << result.time
+             << '}';
+        return json.str();
+    }
+
+    std::string ErrorJson(uint64_t index, const std::string& line, FenStatus status) {
+        return "{\"index\":" + std::to_string(index) + ",\"line\":" + JsonString(line)
+             + ",\"error\":" + JsonString(ToString(status)) + "}";
+    }
+
+    void Work(Batch& batch, TranspositionTable& table, const SearchLimits& limits, std::atomic<uint64_t>& nodes) {
+        const std::atomic<bool> stop = false;
+        auto pos = std::make_unique<Position>();
+        EpdRecord record;
+        std::string line;
+        uint64_t index;
+        while (batch.NextLine(line, index)) {
+            FenStatus status = ParseEPD(line, *pos, record);
+            if (status != FenStatus::Ok) {
+                batch.Emit(index, ErrorJson(index, line, status));
+                continue;
+            }
+            SearchResult result = Search(*pos, table, limits, stop);
+            nodes.fetch_add(result.nodes, std::memory_order_relaxed);
+            batch.Emit(index, ResultJson(index, record, pos->GetFEN(), result));
+        }
+    }
+
+    void PrintUsage(const char* program) {
+        std::cerr
+            << "usage: " << program << " batch [options]\n"
+            << "  --input <file>       FEN or EPD lines, \"-\" for stdin (default: -)\n"
+            << "  --threads <n>        worker threads, each searching its own position (default: 1)\n"
+            << "  --depth <n>          depth limit (default: 6 without another limit)\n"
+            << "  --nodes <n>          node limit per position\n"
+            << "  --movetime <ms>      time limit per position\n"
+            << "  --hash <mb>          transposition table size (default: 16)\n"
+            << "  --partition-hash     give each worker its own part of the table instead of sharing it\n"
+            << "  --completion-order   write the results as they finish instead of in input order\n";
+    }
+}
+
+int RunBatch(int argc, char** argv) {
+    BatchOptions options;
+    options.limits.depth = 0;
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--input") == 0 && i + 1 < argc)            options.input = argv[++i];
+        else if (std::strcmp(arg, "--threads") == 0 && i + 1 < argc)    options.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--depth") == 0 && i + 1 < argc)      options.limits.depth = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--nodes") == 0 && i + 1 < argc)      options.limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--movetime") == 0 && i + 1 < argc)   options.limits.moveTime = std::atoll(argv[++i]);
+        else if (std::strcmp(arg, "--hash") == 0 && i + 1 < argc)       options.hashMegabytes = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--partition-hash") == 0)             options.partitionHash = true;
+        else if (std::strcmp(arg, "--completion-order") == 0)           options.inputOrder = false;
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.limits.depth == 0) options.limits.depth = options.limits.nodes || options.limits.moveTime ? MAX_PLY - 1 : 6;
+
+    size_t tableMegabytes = options.partitionHash ? options.hashMegabytes / std::max(options.threads, 1) : options.hashMegabytes;
+    if (options.threads < 1 || options.limits.depth < 1 || options.limits.depth >= MAX_PLY || tableMegabytes < 1) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream file;
+    if (std::strcmp(options.input, "-") != 0) {
+        file.open(options.input);
+        if (!file) {
+            std::cerr << "cannot open " << options.input << std::endl;
+            return 1;
+        }
+    }
+    Batch batch(file.is_open() ? file : std::cin, std::cout, options.inputOrder);
+
+    std::vector<std::unique_ptr<TranspositionTable>> tables;
+    for (int i = 0; i < (options.partitionHash ? options.threads : 1); ++i) {
+        tables.push_back(std::make_unique<TranspositionTable>(tableMegabytes));
+    }
+    // A shared table is aged once for the whole run: with an age per position, the entries of the
+    // other workers would look stale and always be replaced
+    if (!options.partitionHash) {
+        tables[0]->NewSearch();
+        options.limits.newTableAge = false;
+    }
+
+    std::atomic<uint64_t> nodes = 0;
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.threads; ++i) {
+        TranspositionTable& table = *tables[options.partitionHash ? i : 0];
+        workers.emplace_back(Work, std::ref(batch), std::ref(table), std::cref(options.limits), std::ref(nodes));
+    }
+    for (std::thread& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cerr << std::fixed << std::setprecision(1)
+              << batch.GetCount() << " positions in " << seconds << " s: "
+              << batch.GetCount() / std::max(seconds, 1e-9) << " positions/s, "
+              << nodes.load() / std::max(seconds, 1e-9) / 1e6 << " Mnps" << std::endl;
+    return 0;
+}
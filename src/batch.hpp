@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * Batch analysis: searches every FEN or EPD line of a file (or stdin) on a pool of worker threads
+ * and streams one JSON object per position to stdout
+ * Each worker has its own Position and search state; the transposition table is either shared by
+ * all workers or split into one table per worker
+ * Returns the process exit code
+ */
+int RunBatch(int argc, char** argv);
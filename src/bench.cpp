@@ -0,0 +1,52 @@
+#include "bench.hpp"
+#include "search.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+static const char* const BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R b KQ - 3 8",
+    "2r2rk1/1b2qppp/p3pn2/1p6/3N4/P1B1P3/1P2QPPP/2R2RK1 w - - 0 19",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "rnbqkb1r/ppp1pppp/5n2/3p4/3P4/5N2/PPP1PPPP/RNBQKB1R w KQkq - 2 3",
+    "r2q1rk1/ppp2ppp/2np1n2/2b1p1B1/2B1P1b1/2NP1N2/PPP2PPP/R2Q1RK1 w - - 2 8",
+    "3r1rk1/pp3ppp/2n1b3/2bp4/8/2N1BN2/PPP2PPP/3R1RK1 w - - 4 15",
+    "8/5pk1/6p1/3R3p/1r5P/6P1/5PK1/8 b - - 4 41",
+    "8/8/4k3/3n4/8/2K5/3B4/8 w - - 12 67",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/8/4k3/8/8/4P3/4K3 w - - 0 1",
+};
+
+uint64_t Bench(std::ostream& out, int depth) {
+    TranspositionTable table(BENCH_HASH_MB);
+    std::atomic<bool> stop = false;
+    SearchLimits limits;
+    limits.depth = depth;
+
+    uint64_t nodes = 0;
+    int64_t time = 0;
+    for (size_t i = 0; i < std::size(BENCH_FENS); ++i) {
+        Position pos(BENCH_FENS[i]);
+        table.Clear();
+        SearchResult result = Search(pos, table, limits, stop);
+        nodes += result.nodes;
+        time += result.time;
+        out << "Position " << i + 1 << '/' << std::size(BENCH_FENS) << ": " << result.nodes << " nodes, "
+            << "bestmove " << result.bestMove.ToUCI() << '\n';
+    }
+
+    out << "===========================\n"
+        << "Total time (ms) : " << time << '\n'
+        << "Nodes searched  : " << nodes << '\n'
+        << "Nodes/second    : " << nodes * 1000 / std::max<int64_t>(time, 1) << std::endl;
+    Profile::Dump(out);
+    return nodes;
+}
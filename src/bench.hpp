@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+constexpr int BENCH_DEPTH = 6;
+constexpr size_t BENCH_HASH_MB = 16;
+
+/**
+ * Searches a fixed set of positions to a fixed depth, single-threaded and with a cleared hash table
+ * of fixed size before each position, and prints the total nodes and the speed
+ * The total is a signature of the search: it only changes when the search behaves differently
+ * Returns the total number of nodes
+ */
+uint64_t Bench(std::ostream& out, int depth = BENCH_DEPTH);
@@ -0,0 +1,110 @@
+#include "position.hpp"
+#include "move_list.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+// Compares whole-side slider attack maps computed with one table lookup per piece against
+// the set-wise Kogge-Stone fills of BB::SliderAttacks
+
+static const char* const FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+#if defined(__AVX2__)
+static constexpr const char* Implementation = "AVX2";
+#elif defined(__SSE2__)
+static constexpr const char* Implementation = "SSE2";
+#else
+static constexpr const char* Implementation = "scalar";
+#endif
+
+struct Sample {
+    Bitboard straightSliders;
+    Bitboard diagonalSliders;
+    Bitboard occupancy;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static void CollectSamples(Position& pos, int depth, std::vector<Sample>& samples) {
+    for (Color color : { Color::White, Color::Black }) {
+        Bitboard queens = pos.GetPiecesBB(color, PieceType::Queen);
+        samples.push_back({
+            pos.GetPiecesBB(color, PieceType::Rook) | queens,
+            pos.GetPiecesBB(color, PieceType::Bishop) | queens,
+            pos.GetOccupancy()
+        });
+    }
+    if (depth == 0) return;
+    for (Move move : MoveList(pos)) {
+        pos.DoMove(move);
+        CollectSamples(pos, depth - 1, samples);
+        pos.UndoMove();
+    }
+}
+
+static Bitboard PerPieceAttacks(const Sample& sample) {
+    Bitboard attacks = BB::NONE;
+    Bitboard straightSliders = sample.straightSliders;
+    while (straightSliders) attacks |= BB::Attacks<PieceType::Rook>(BB::PopLsb(straightSliders), sample.occupancy);
+    Bitboard diagonalSliders = sample.diagonalSliders;
+    while (diagonalSliders) attacks |= BB::Attacks<PieceType::Bishop>(BB::PopLsb(diagonalSliders), sample.occupancy);
+    return attacks;
+}
+
+static Bitboard KoggeStoneAttacks(const Sample& sample) {
+    return BB::SliderAttacks(sample.straightSliders, sample.diagonalSliders, sample.occupancy);
+}
+
+template <Bitboard (&ComputeAttacks)(const Sample&)>
+static double NanosecondsPerSample(const std::vector<Sample>& samples, int rounds, Bitboard& checksum) {
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Sample& sample : samples) checksum ^= ComputeAttacks(sample) + round;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return seconds * 1e9 / (double(samples.size()) * rounds);
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 20;
+    if (rounds < 1) {
+        std::cerr << "usage: " << argv[0] << " [rounds]" << std::endl;
+        return 1;
+    }
+
+    std::vector<Sample> samples;
+    for (const char* fen : FENS) {
+        Position pos(fen);
+        CollectSamples(pos, 3, samples);
+    }
+
+    size_t mismatches = 0;
+    for (const Sample& sample : samples) {
+        mismatches += PerPieceAttacks(sample) != KoggeStoneAttacks(sample);
+    }
+
+    Bitboard checksumPerPiece = 0, checksumKoggeStone = 0;
+    double perPiece = NanosecondsPerSample<PerPieceAttacks>(samples, rounds, checksumPerPiece);
+    double koggeStone = NanosecondsPerSample<KoggeStoneAttacks>(samples, rounds, checksumKoggeStone);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << samples.size() << " attack maps, " << rounds << " rounds\n"
+              << "  per-piece lookups    " << std::setw(8) << perPiece << " ns\n"
+              << "  Kogge-Stone (" << Implementation << ") " << std::setw(8) << koggeStone << " ns\n";
+
+    if (mismatches || checksumPerPiece != checksumKoggeStone) {
+        std::cout << "FAILED: " << mismatches << " attack maps differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
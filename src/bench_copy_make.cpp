@@ -0,0 +1,119 @@
+#include "position.hpp"
+#include "compact_position.hpp"
+#include "move_list.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+// Compares the make/unmake Position against the copy-make CompactPosition:
+// object size, construction cost and perft throughput
+
+static constexpr int MAX_PLY = 64;
+
+static const char* const FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static uint64_t PerftMakeUnmake(Position& pos, int depth) {
+    MoveList moveList(pos);
+    if (depth == 1) return moveList.end() - moveList.begin();
+
+    uint64_t numMoves = 0;
+    for (Move move : moveList) {
+        pos.DoMove(move);
+        numMoves += PerftMakeUnmake(pos, depth - 1);
+        pos.UndoMove();
+    }
+    return numMoves;
+}
+
+static uint64_t PerftCopyMake(CompactPosition* stack, int depth) {
+    MoveList moveList(stack[0]);
+    if (depth == 1) return moveList.end() - moveList.begin();
+
+    uint64_t numMoves = 0;
+    for (Move move : moveList) {
+        stack[0].DoMove(move, stack[1]);
+        numMoves += PerftCopyMake(stack + 1, depth - 1);
+    }
+    return numMoves;
+}
+
+template <typename Pos>
+static double ConstructionNanoseconds(int iterations) {
+    uint64_t checksum = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Pos pos(FENS[i % std::size(FENS)]);
+        checksum += pos.GetZobristHash();
+    }
+    double seconds = SecondsSince(start);
+    if (checksum == 42) std::cout << "";   // Keep the loop alive
+    return seconds * 1e9 / iterations;
+}
+
+int main(int argc, char** argv) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (depth < 1 || depth >= MAX_PLY) {
+        std::cerr << "usage: " << argv[0] << " [depth]" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "sizeof(Position)        = " << sizeof(Position) << " bytes\n";
+    std::cout << "sizeof(CompactPosition) = " << sizeof(CompactPosition) << " bytes\n\n";
+
+    constexpr int ConstructionIterations = 20000;
+    std::cout << "construction from fen: "
+              << "Position " << ConstructionNanoseconds<Position>(ConstructionIterations) << " ns, "
+              << "CompactPosition " << ConstructionNanoseconds<CompactPosition>(ConstructionIterations) << " ns\n\n";
+
+    bool mismatch = false;
+    double totalMakeUnmake = 0, totalCopyMake = 0;
+    uint64_t totalNodes = 0;
+    for (const char* fen : FENS) {
+        Position pos(fen);
+        auto start = Clock::now();
+        uint64_t nodesMakeUnmake = PerftMakeUnmake(pos, depth);
+        double secondsMakeUnmake = SecondsSince(start);
+
+        Array<CompactPosition, MAX_PLY> stack;
+        stack[0] = CompactPosition(fen);
+        start = Clock::now();
+        uint64_t nodesCopyMake = PerftCopyMake(stack.data(), depth);
+        double secondsCopyMake = SecondsSince(start);
+
+        std::cout << fen << '\n'
+                  << "  make/unmake " << std::setw(12) << nodesMakeUnmake << " nodes "
+                  << std::setw(8) << nodesMakeUnmake / secondsMakeUnmake / 1e6 << " Mnps\n"
+                  << "  copy-make   " << std::setw(12) << nodesCopyMake << " nodes "
+                  << std::setw(8) << nodesCopyMake / secondsCopyMake / 1e6 << " Mnps\n";
+
+        mismatch |= nodesMakeUnmake != nodesCopyMake;
+        totalNodes += nodesMakeUnmake;
+        totalMakeUnmake += secondsMakeUnmake;
+        totalCopyMake += secondsCopyMake;
+    }
+
+    std::cout << "\ntotal: make/unmake " << totalNodes / totalMakeUnmake / 1e6 << " Mnps, "
+              << "copy-make " << totalNodes / totalCopyMake / 1e6 << " Mnps\n";
+
+    if (mismatch) {
+        std::cout << "FAILED: node counts differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
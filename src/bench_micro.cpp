@@ -0,0 +1,273 @@
+#include "position.hpp"
+#include "move_generation.hpp"
+#include "move_list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// Times the hot primitives one by one (ns per operation, after warmup, median of several
+// repetitions) so that a regression shows up in the primitive that caused it and not only in NPS
+
+static const char* const FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R b KQ - 3 8",
+    "2r2rk1/1b2qppp/p3pn2/1p6/3N4/P1B1P3/1P2QPPP/2R2RK1 w - - 0 19",
+    "8/5pk1/6p1/3R3p/1r5P/6P1/5PK1/8 b - - 4 41",
+    "8/8/4k3/3n4/8/2K5/3B4/8 w - - 12 67",
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the compiler from discarding a computation whose result is otherwise unused
+template <typename T>
+static void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark {
+    const char* name;
+    size_t opsPerRun;
+    std::function<void()> run;
+};
+
+struct BenchmarkResult {
+    const char* name;
+    uint64_t ops;
+    double nsPerOpMin;
+    double nsPerOpMedian;
+};
+
+struct Options {
+    int warmup = 2;
+    int repetitions = 10;
+    double minSecondsPerRepetition = 0.02;
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+};
+
+// Representative positions and everything the benchmarks need precomputed from them, so that the
+// timed loops only contain the primitive under test
+struct Samples {
+    std::vector<Position> positions;
+    std::vector<std::vector<Move>> moves;
+    std::vector<std::string> fens;
+    std::vector<std::pair<Square, Bitboard>> squaresAndOccupancies;
+    std::vector<Bitboard> occupancies;
+    size_t moveCount = 0;
+    size_t occupiedCount = 0;
+
+    Samples() {
+        positions.reserve(std::size(FENS));
+        for (const char* fen : FENS) {
+            Position& pos = positions.emplace_back(fen);
+            MoveList moveList(pos);
+            moves.emplace_back(moveList.begin(), moveList.end());
+            moveCount += moveList.size();
+            fens.push_back(pos.GetFEN());
+            occupancies.push_back(pos.GetOccupancy());
+            occupiedCount += BB::Count1s(pos.GetOccupancy());
+            for (int square = 0; square < SQUARE_NUM; ++square) {
+                squaresAndOccupancies.emplace_back(ToSquare(square), pos.GetOccupancy());
+            }
+        }
+    }
+};
+
+template <PieceType Type>
+static Benchmark AttacksBenchmark(const char* name, const Samples& samples) {
+    return { name, samples.squaresAndOccupancies.size(), [&samples] {
+        Bitboard attacks = BB::NONE;
+        for (auto [square, occupancy] : samples.squaresAndOccupancies) {
+            attacks ^= BB::Attacks<Type>(square, occupancy);
+        }
+        DoNotOptimize(attacks);
+    }};
+}
+
+template <GenType Type>
+static Benchmark GenerateMovesBenchmark(const char* name, const Samples& samples) {
+    return { name, samples.positions.size(), [&samples] {
+        Array<Move, MAX_MOVES> list;
+        for (const Position& pos : samples.positions) {
+            Move* end = GenerateMoves<Type>(list.data(), pos);
+            DoNotOptimize(end);
+        }
+    }};
+}
+
+static std::vector<Benchmark> MakeBenchmarks(Samples& samples) {
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back(AttacksBenchmark<PieceType::Rook>("attacks_rook", samples));
+    benchmarks.push_back(AttacksBenchmark<PieceType::Bishop>("attacks_bishop", samples));
+    benchmarks.push_back(AttacksBenchmark<PieceType::Queen>("attacks_queen", samples));
+
+    benchmarks.push_back({ "pop_lsb", samples.occupiedCount, [&samples] {
+        int sum = 0;
+        for (Bitboard bb : samples.occupancies) {
+            DoNotOptimize(bb);
+            while (bb) sum += ToInt(BB::PopLsb(bb));
+        }
+        DoNotOptimize(sum);
+    }});
+
+    benchmarks.push_back(GenerateMovesBenchmark<GenType::All>("generate_moves_all", samples));
+    benchmarks.push_back(GenerateMovesBenchmark<GenType::Captures>("generate_moves_captures", samples));
+    benchmarks.push_back(GenerateMovesBenchmark<GenType::Quiets>("generate_moves_quiets", samples));
+
+    benchmarks.push_back({ "do_undo_move", samples.moveCount, [&samples] {
+        for (size_t i = 0; i < samples.positions.size(); ++i) {
+            Position& pos = samples.positions[i];
+            for (Move move : samples.moves[i]) {
+                pos.DoMove(move);
+                pos.UndoMove();
+            }
+        }
+    }});
+
+    // The updates DoMove makes to the hash for a move: moved piece, captured piece and side to move
+    benchmarks.push_back({ "zobrist_update", samples.moveCount, [&samples] {
+        for (size_t i = 0; i < samples.positions.size(); ++i) {
+            const Position& pos = samples.positions[i];
+            ZobristHash hash = pos.GetZobristHash();
+            for (Move move : samples.moves[i]) {
+                Piece piece = pos.GetBoard(move.GetFrom());
+                hash.SwitchPiece(move.GetFrom(), piece);
+                hash.SwitchPiece(move.GetTo(), piece);
+                if (move.IsNormalCapture()) hash.SwitchPiece(move.GetTo(), pos.GetBoard(move.GetTo()));
+                hash.SwitchSideToMove();
+            }
+            DoNotOptimize(hash);
+        }
+    }});
+
+    // Parses into an existing position: constructing one would mostly time the zeroing of the move history
+    benchmarks.push_back({ "parse_fen", samples.fens.size(), [&samples] {
+        Position& pos = samples.positions.back();
+        for (const std::string& fen : samples.fens) {
+            std::string_view view = fen;
+            FenStatus status = pos.ParseFEN(view);
+            DoNotOptimize(status);
+        }
+        std::string_view last = samples.fens.back();
+        pos.ParseFEN(last);
+    }});
+
+    benchmarks.push_back({ "get_fen", samples.positions.size(), [&samples] {
+        for (const Position& pos : samples.positions) {
+            std::string fen = pos.GetFEN();
+            DoNotOptimize(fen.data());
+        }
+    }});
+
+    return benchmarks;
+}
+
+static double TimeRuns(const Benchmark& benchmark, size_t runs) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < runs; ++i) benchmark.run();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static BenchmarkResult RunBenchmark(const Benchmark& benchmark, const Options& options) {
+    for (int i = 0; i < options.warmup; ++i) benchmark.run();
+
+    // Repeat the run enough times that one repetition is long enough to time reliably
+    size_t runs = 1;
+    while (TimeRuns(benchmark, runs) < options.minSecondsPerRepetition / 4) runs *= 2;
+    runs *= 4;
+
+    std::vector<double> nsPerOp;
+    for (int i = 0; i < options.repetitions; ++i) {
+        double seconds = TimeRuns(benchmark, runs);
+        nsPerOp.push_back(seconds * 1e9 / (double(runs) * benchmark.opsPerRun));
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    return { benchmark.name, uint64_t(runs * benchmark.opsPerRun), nsPerOp.front(), nsPerOp[nsPerOp.size() / 2] };
+}
+
+static void WriteJson(std::ostream& out, const std::vector<BenchmarkResult>& results, const Options& options) {
+    out << std::fixed << std::setprecision(3)
+        << "{\n"
+        << "  \"warmup\": " << options.warmup << ",\n"
+        << "  \"repetitions\": " << options.repetitions << ",\n"
+        << "  \"positions\": " << std::size(FENS) << ",\n"
+        << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        out << "    { \"name\": \"" << result.name << "\""
+            << ", \"ops_per_repetition\": " << result.ops
+            << ", \"ns_per_op_min\": " << result.nsPerOpMin
+            << ", \"ns_per_op_median\": " << result.nsPerOpMedian
+            << " }" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n"
+        << "}\n";
+}
+
+static void PrintUsage(const char* program) {
+    std::cerr
+        << "usage: " << program << " [options]\n"
+        << "  --repetitions <n>  timed repetitions per benchmark, the median is reported (default: 10)\n"
+        << "  --warmup <n>       untimed runs before measuring (default: 2)\n"
+        << "  --filter <text>    only run the benchmarks whose name contains the text\n"
+        << "  --json <file>      also write the results as JSON, \"-\" for stdout\n";
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--repetitions") == 0 && i + 1 < argc)     options.repetitions = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--warmup") == 0 && i + 1 < argc)     options.warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--filter") == 0 && i + 1 < argc)     options.filter = argv[++i];
+        else if (std::strcmp(arg, "--json") == 0 && i + 1 < argc)       options.jsonPath = argv[++i];
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.repetitions < 1 || options.warmup < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    bool jsonToStdout = options.jsonPath && std::strcmp(options.jsonPath, "-") == 0;
+    std::ostream& log = jsonToStdout ? std::cerr : std::cout;
+
+    Samples samples;
+    std::vector<BenchmarkResult> results;
+    log << std::fixed << std::setprecision(2);
+    for (const Benchmark& benchmark : MakeBenchmarks(samples)) {
+        if (options.filter && !std::strstr(benchmark.name, options.filter)) continue;
+        BenchmarkResult result = RunBenchmark(benchmark, options);
+        log << std::left << std::setw(26) << result.name << std::right
+            << std::setw(10) << result.nsPerOpMedian << " ns/op  (min " << result.nsPerOpMin << ")" << std::endl;
+        results.push_back(result);
+    }
+
+    if (jsonToStdout) {
+        WriteJson(std::cout, results, options);
+    } else if (options.jsonPath) {
+        std::ofstream file(options.jsonPath);
+        if (!file) {
+            std::cerr << "cannot write " << options.jsonPath << std::endl;
+            return 1;
+        }
+        WriteJson(file, results, options);
+    }
+    return 0;
+}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <type_traits>
 #include "types.hpp"
 
+#if defined(USE_PEXT) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 using Bitboard = uint64_t;
 
 /**
@@ -34,8 +39,6 @@ public:
     static constexpr Bitboard RANK_7 = RANK_1 << (8 * 6);
     static constexpr Bitboard RANK_8 = RANK_1 << (8 * 7);
 
-    static void Init();
-
     static constexpr Bitboard FileBB(BoardFile file);
     static constexpr Bitboard RankBB(BoardRank rank);
     static constexpr Bitboard SquareBB(Square square);
@@ -60,6 +63,8 @@ public:
     static Bitboard Line(Square sq1, Square sq2);
     static bool OnLine(Square sq1, Square sq2, Square sq3);
 
+    static Bitboard SliderAttacks(Bitboard straightSliders, Bitboard diagonalSliders, Bitboard occupancy);
+
     static uint32_t Count1s(Bitboard bb);
     static bool AtLeast2(Bitboard bb);
     static Bitboard LsbBB(Bitboard bb);
@@ -71,14 +76,26 @@ public:
     BB() = delete;
 
 private:
+    /**
+     * Slider attack lookup for one square
+     * With USE_PEXT (BMI2) the relevant occupancy bits are extracted directly, otherwise they are
+     * hashed with a magic multiplication. Both index the same table layout
+     */
     struct Magic {
-        Bitboard* table;
+        const Bitboard* table;
         Bitboard mask;
+#ifndef USE_PEXT
         uint64_t mult;
         uint8_t shift;
+#endif
 
-        uint64_t TableIndex(Bitboard occupancy) const {
+        constexpr uint64_t TableIndex(Bitboard occupancy) const {
+#ifdef USE_PEXT
+            if (std::is_constant_evaluated()) return SoftwarePext(occupancy, mask);
+            return _pext_u64(occupancy, mask);
+#else
             return ((occupancy & mask) * mult) >> shift;
+#endif
         }
 
         Bitboard Attacks(Bitboard occupancy) const {
@@ -86,22 +103,45 @@ private:
         }
     };
 
-    static bool initialized;
-
-    static Array2D<Bitboard, PIECE_TYPE_NUM, SQUARE_NUM> pseudoAttacks;
-    static Array<Magic, SQUARE_NUM> rookAttacks;
-    static Array<Magic, SQUARE_NUM> bishopAttacks;
-    static Array2D<Bitboard, SQUARE_NUM, SQUARE_NUM> between;
-    static Array2D<Bitboard, SQUARE_NUM, SQUARE_NUM> line;
-
-    static void InitPseudoAttacks();
-    static void InitMagicBitboards();
-    static Bitboard* InitMagicBitboards(PieceType pieceType, Square square, Bitboard* tableStart);
-    static void InitBetween();
-    static void InitLine();
+    // Sum of 2^(relevant occupancy bits) over all squares
+    static constexpr size_t ROOK_TABLE_SIZE     = 102400;
+    static constexpr size_t BISHOP_TABLE_SIZE   = 5248;
+
+    // All tables are computed at compile time (see bitboard.cpp) and live in read-only data
+    static const Array2D<Bitboard, PIECE_TYPE_NUM, SQUARE_NUM> pseudoAttacks;
+    static const Array<Bitboard, ROOK_TABLE_SIZE> rookAttacksTable;
+    static const Array<Bitboard, BISHOP_TABLE_SIZE> bishopAttacksTable;
+    static const Array<Magic, SQUARE_NUM> rookAttacks;
+    static const Array<Magic, SQUARE_NUM> bishopAttacks;
+    static const Array2D<Bitboard, SQUARE_NUM, SQUARE_NUM> between;
+    static const Array2D<Bitboard, SQUARE_NUM, SQUARE_NUM> line;
+
+    static constexpr uint64_t SoftwarePext(Bitboard occupancy, Bitboard mask);
+
+    template <int shift>
+    static Bitboard KoggeStoneAttacks(Bitboard generators, Bitboard empty);
+#if defined(__SSE2__) && !defined(__AVX2__)
+    template <int shift, bool opposite>
+    static __m128i ShiftLanes(__m128i v);
+    template <int shift, bool opposite>
+    static __m128i KoggeStoneAttacks(__m128i generators, __m128i empty, __m128i notWrapped);
+#endif
+    static constexpr Array<Magic, SQUARE_NUM> ComputeMagics(PieceType pieceType, const Bitboard* table);
+    template <PieceType pieceType, size_t tableSize>
+    static constexpr Array<Bitboard, tableSize> ComputeAttacksTable();
     
 };
 
+// Bit by bit equivalent of _pext_u64, only used while computing the tables at compile time
+constexpr uint64_t BB::SoftwarePext(Bitboard occupancy, Bitboard mask) {
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (occupancy & mask & -mask) result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
 constexpr Bitboard BB::FileBB(BoardFile file) {
     return FILE_A << ToInt(file);
 }
@@ -131,14 +171,12 @@ constexpr Bitboard BB::Shift(Bitboard bb) {
 template <PieceType pieceType>
 inline Bitboard BB::Attacks(Square square) {
     static_assert(pieceType != PieceType::Pawn);
-    assert(initialized);
     return pseudoAttacks[ToInt(pieceType)][ToInt(square)]; 
 }
 
 template <PieceType pieceType>
 inline Bitboard BB::Attacks(Square square, Bitboard occupancy) {
     static_assert(pieceType != PieceType::Pawn);
-    assert(initialized);
 
     if constexpr (pieceType == PieceType::Queen) {
         return 
@@ -172,13 +210,11 @@ constexpr Bitboard BB::PawnAttacks(Square square) {
 
 inline Bitboard BB::Attacks(PieceType pieceType, Square square) {
     assert(pieceType != PieceType::Pawn);
-    assert(initialized);
     return pseudoAttacks[ToInt(pieceType)][ToInt(square)]; 
 }
 
 inline Bitboard BB::Attacks(PieceType pieceType, Square square, Bitboard occupancy) {
     assert(pieceType != PieceType::Pawn);
-    assert(initialized);
 
     switch (pieceType) {
     case PieceType::Queen:  return Attacks<PieceType::Queen>(square, occupancy);
@@ -201,12 +237,10 @@ inline constexpr Bitboard BB::PawnAttacks(Color color, Square square) {
 }
 
 inline Bitboard BB::Between(Square sq1, Square sq2) {
-    assert(initialized);
     return between[ToInt(sq1)][ToInt(sq2)];
 }
 
 inline Bitboard BB::Line(Square sq1, Square sq2) {
-    assert(initialized);
     return line[ToInt(sq1)][ToInt(sq2)];
 }
 
@@ -214,6 +248,124 @@ inline bool BB::OnLine(Square sq1, Square sq2, Square sq3) {
     return (Line(sq1, sq2) & SquareBB(sq3)) != 0;
 }
 
+// Occluded fill in one direction, shifted once more to get the attacked squares
+template <int shift>
+inline Bitboard BB::KoggeStoneAttacks(Bitboard generators, Bitboard empty) {
+    constexpr int Sideways = shift % 8;
+    constexpr Bitboard NotWrapped = 
+        Sideways == 1 || Sideways == -7 ? ~FILE_A :
+        Sideways == -1 || Sideways == 7 ? ~FILE_H : ALL;
+    constexpr auto ShiftBy = [](Bitboard bb, int n) {
+        if constexpr (shift > 0)    return bb << (n * shift);
+        else                        return bb >> (-n * shift);
+    };
+
+    Bitboard propagators = empty & NotWrapped;
+    generators |= propagators & ShiftBy(generators, 1);
+    propagators &= ShiftBy(propagators, 1);
+    generators |= propagators & ShiftBy(generators, 2);
+    propagators &= ShiftBy(propagators, 2);
+    generators |= propagators & ShiftBy(generators, 4);
+    return ShiftBy(generators, 1) & NotWrapped;
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+
+// SSE2 only shifts both lanes by the same amount: for opposite directions shift twice and blend
+// the low lane of the left shift with the high lane of the right shift
+template <int shift, bool opposite>
+inline __m128i BB::ShiftLanes(__m128i v) {
+    if constexpr (opposite) {
+        return _mm_castpd_si128(_mm_move_sd(
+            _mm_castsi128_pd(_mm_srli_epi64(v, shift)), _mm_castsi128_pd(_mm_slli_epi64(v, shift))));
+    } else {
+        return _mm_slli_epi64(v, shift);
+    }
+}
+
+template <int shift, bool opposite>
+inline __m128i BB::KoggeStoneAttacks(__m128i generators, __m128i empty, __m128i notWrapped) {
+    __m128i propagators = _mm_and_si128(empty, notWrapped);
+    generators = _mm_or_si128(generators, _mm_and_si128(propagators, ShiftLanes<shift, opposite>(generators)));
+    propagators = _mm_and_si128(propagators, ShiftLanes<shift, opposite>(propagators));
+    generators = _mm_or_si128(generators, _mm_and_si128(propagators, ShiftLanes<2 * shift, opposite>(generators)));
+    propagators = _mm_and_si128(propagators, ShiftLanes<2 * shift, opposite>(propagators));
+    generators = _mm_or_si128(generators, _mm_and_si128(propagators, ShiftLanes<4 * shift, opposite>(generators)));
+    return _mm_and_si128(ShiftLanes<shift, opposite>(generators), notWrapped);
+}
+
+#endif
+
+/**
+ * Attacks of all given sliders together, computed set-wise with Kogge-Stone fills instead of one
+ * table lookup per piece. The directions are processed in parallel: four per vector with AVX2,
+ * two with SSE2 (one of them on the flipped board), otherwise one at a time
+ * See https://www.chessprogramming.org/Kogge-Stone_Algorithm
+ */
+inline Bitboard BB::SliderAttacks(Bitboard straightSliders, Bitboard diagonalSliders, Bitboard occupancy) {
+    const Bitboard empty = ~occupancy;
+
+#if defined(__AVX2__)
+
+    // Lanes: Up/Down, Right/Left, UpRight/DownLeft, UpLeft/DownRight
+    const __m256i shift1 = _mm256_setr_epi64x(8, 1, 9, 7);
+    const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+    const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+    const __m256i emptyV = _mm256_set1_epi64x(empty);
+    const __m256i notWrappedUp = _mm256_setr_epi64x(ALL, ~FILE_A, ~FILE_A, ~FILE_H);
+    const __m256i notWrappedDown = _mm256_setr_epi64x(ALL, ~FILE_H, ~FILE_H, ~FILE_A);
+
+    __m256i up = _mm256_setr_epi64x(straightSliders, straightSliders, diagonalSliders, diagonalSliders);
+    __m256i down = up;
+    __m256i proUp = _mm256_and_si256(emptyV, notWrappedUp);
+    __m256i proDown = _mm256_and_si256(emptyV, notWrappedDown);
+
+    up = _mm256_or_si256(up, _mm256_and_si256(proUp, _mm256_sllv_epi64(up, shift1)));
+    down = _mm256_or_si256(down, _mm256_and_si256(proDown, _mm256_srlv_epi64(down, shift1)));
+    proUp = _mm256_and_si256(proUp, _mm256_sllv_epi64(proUp, shift1));
+    proDown = _mm256_and_si256(proDown, _mm256_srlv_epi64(proDown, shift1));
+    up = _mm256_or_si256(up, _mm256_and_si256(proUp, _mm256_sllv_epi64(up, shift2)));
+    down = _mm256_or_si256(down, _mm256_and_si256(proDown, _mm256_srlv_epi64(down, shift2)));
+    proUp = _mm256_and_si256(proUp, _mm256_sllv_epi64(proUp, shift2));
+    proDown = _mm256_and_si256(proDown, _mm256_srlv_epi64(proDown, shift2));
+    up = _mm256_or_si256(up, _mm256_and_si256(proUp, _mm256_sllv_epi64(up, shift4)));
+    down = _mm256_or_si256(down, _mm256_and_si256(proDown, _mm256_srlv_epi64(down, shift4)));
+    up = _mm256_and_si256(_mm256_sllv_epi64(up, shift1), notWrappedUp);
+    down = _mm256_and_si256(_mm256_srlv_epi64(down, shift1), notWrappedDown);
+
+    __m256i attacks = _mm256_or_si256(up, down);
+    __m128i attacks2 = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+    return _mm_cvtsi128_si64(_mm_or_si128(attacks2, _mm_unpackhi_epi64(attacks2, attacks2)));
+
+#elif defined(__SSE2__)
+
+    // The high lane holds the vertically flipped board, so shifting up there means shifting down
+    const __m128i emptyV = _mm_set_epi64x(__builtin_bswap64(empty), empty);
+    const __m128i straightV = _mm_set_epi64x(__builtin_bswap64(straightSliders), straightSliders);
+    const __m128i diagonalV = _mm_set_epi64x(__builtin_bswap64(diagonalSliders), diagonalSliders);
+
+    // Up/Down, UpRight/DownRight, UpLeft/DownLeft and Right/Left
+    __m128i attacks = KoggeStoneAttacks<8, false>(straightV, emptyV, _mm_set1_epi64x(ALL));
+    attacks = _mm_or_si128(attacks, KoggeStoneAttacks<9, false>(diagonalV, emptyV, _mm_set1_epi64x(~FILE_A)));
+    attacks = _mm_or_si128(attacks, KoggeStoneAttacks<7, false>(diagonalV, emptyV, _mm_set1_epi64x(~FILE_H)));
+    attacks = _mm_or_si128(attacks, KoggeStoneAttacks<1, true>(straightV, emptyV, _mm_set_epi64x(~FILE_H, ~FILE_A)));
+    return _mm_cvtsi128_si64(attacks) | __builtin_bswap64(_mm_cvtsi128_si64(_mm_unpackhi_epi64(attacks, attacks)));
+
+#else
+
+    return
+        KoggeStoneAttacks<ToInt(Direction::Up)>(straightSliders, empty)         |
+        KoggeStoneAttacks<ToInt(Direction::Down)>(straightSliders, empty)       |
+        KoggeStoneAttacks<ToInt(Direction::Left)>(straightSliders, empty)       |
+        KoggeStoneAttacks<ToInt(Direction::Right)>(straightSliders, empty)      |
+        KoggeStoneAttacks<ToInt(Direction::UpLeft)>(diagonalSliders, empty)     |
+        KoggeStoneAttacks<ToInt(Direction::UpRight)>(diagonalSliders, empty)    |
+        KoggeStoneAttacks<ToInt(Direction::DownLeft)>(diagonalSliders, empty)   |
+        KoggeStoneAttacks<ToInt(Direction::DownRight)>(diagonalSliders, empty);
+
+#endif
+}
+
 inline uint32_t BB::Count1s(Bitboard bb) {
     // TODO: support more compilers
 #if defined(__GNUC__)
@@ -0,0 +1,253 @@
+#include "compact_position.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+static const CompactPosition& StartPosition() {
+    static const CompactPosition start("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    return start;
+}
+
+CompactPosition::CompactPosition() {
+    *this = StartPosition();
+}
+
+CompactPosition::CompactPosition(const Position& pos) {
+    mPiecesBB.fill(BB::NONE);
+    mOccupied.fill(BB::NONE);
+    mBoard.fill(Piece::None);
+
+    for (Square square = Square::A1; square <= Square::H8; ++square) {
+        Piece piece = pos.GetBoard(square);
+        if (piece != Piece::None) AddPiece(piece, square);
+    }
+    mSideToMove             = pos.GetSideToMove();
+    mCastlingRights         = pos.GetCastlingRights();
+    mEnPassant              = pos.GetEnPassant();
+    // The counters are narrower than those of Position
+    mReversableHalfMovesCnt = std::min<uint32_t>(pos.GetReversableHalfMovesCnt(), UINT16_MAX);
+    mMoveNum                = std::min<uint32_t>(pos.GetMoveNum(), UINT16_MAX);
+    mZobristHash            = pos.GetZobristHash();
+
+    UpdateAuxiliaryInfo();
+}
+
+// Parsed by Position, so both types accept and reject the same FENs
+CompactPosition::CompactPosition(const char* fen) : CompactPosition(Position(fen)) {}
+
+void CompactPosition::DoMove(Move move, CompactPosition& next) const {
+    next = *this;
+
+    Square from = move.GetFrom();
+    Square to = move.GetTo();
+
+    if (next.mEnPassant != Square::None) next.NullifyEnPassant();
+
+    if (move.IsQuiet()) {
+        next.MovePiece(from, to);
+        if (move.IsDoublePawnPush()) {
+            next.SetEnPassant(MiddleOf(from, to));
+        }
+    }
+    else if (move.IsNormalCapture()) {
+        next.CapturePiece(from, to);
+    }
+    else if (move.IsEnPassant()) {
+        Square captured = MakeSquare(FileOf(to), RankOf(from));
+        next.RemovePiece(captured);
+        next.MovePiece(from, to);
+    }
+    else if (move.IsCastle()) {
+        BoardFile rookFile = move.IsQueensideCastle() ? BoardFile::A : BoardFile::H;
+        Square rook = MakeSquare(rookFile, RankOf(from));
+        next.MovePiece(from, to);
+        next.MovePiece(rook, MiddleOf(from, to));
+    }
+    else {
+        assert(move.IsPromotion());
+        if (move.IsCapture()) next.RemovePiece(to);
+        next.RemovePiece(from);
+        next.AddPiece(MakePiece(mSideToMove, move.GetPromotionType()), to);
+    }
+
+    if (mSideToMove == Color::White)    next.UpdateCastlingRights<Color::White>(from, to);
+    else                                next.UpdateCastlingRights<Color::Black>(from, to);
+
+    if ((move.IsQuiet() || move.IsCastle()) && PieceTypeOf(next.GetBoard(to)) != PieceType::Pawn) {
+        ++next.mReversableHalfMovesCnt;
+    }
+    else {
+        next.mReversableHalfMovesCnt = 0;
+    }
+    if (mSideToMove == Color::Black) ++next.mMoveNum;
+
+    next.SwitchSideToMove();
+    next.UpdateAuxiliaryInfo();
+}
+
+void CompactPosition::AddPiece(Piece piece, Square square) {
+    assert(Board(square) == Piece::None);
+
+    Bitboard squareBB                = BB::SquareBB(square);
+    Board(square)                    = piece;
+    PiecesBB(PieceTypeOf(piece))    |= squareBB;
+    Occupied(ColorOf(piece))        |= squareBB;
+
+    mZobristHash.SwitchPiece(square, piece);
+}
+
+void CompactPosition::RemovePiece(Square square) {
+    assert(Board(square) != Piece::None);
+
+    Bitboard squareBB                = BB::SquareBB(square);
+    Piece piece                      = Board(square);
+    Board(square)                    = Piece::None;
+    PiecesBB(PieceTypeOf(piece))    ^= squareBB;
+    Occupied(ColorOf(piece))        ^= squareBB;
+
+    mZobristHash.SwitchPiece(square, piece);
+}
+
+void CompactPosition::MovePiece(Square from, Square to) {
+    assert(Board(from) != Piece::None);
+    assert(Board(to) == Piece::None);
+
+    Bitboard bothBB                  = BB::SquareBB(from) | BB::SquareBB(to);
+    Piece piece                      = Board(from);
+    Board(from)                      = Piece::None;
+    Board(to)                        = piece;
+    PiecesBB(PieceTypeOf(piece))    ^= bothBB;
+    Occupied(ColorOf(piece))        ^= bothBB;
+
+    mZobristHash.SwitchPiece(from, piece);
+    mZobristHash.SwitchPiece(to, piece);
+}
+
+void CompactPosition::CapturePiece(Square from, Square to) {
+    assert(Board(from) != Piece::None);
+    assert(Board(to) != Piece::None);
+    assert(PieceTypeOf(Board(to)) != PieceType::King);
+
+    Bitboard toBB                            = BB::SquareBB(to);
+    Bitboard bothBB                          = BB::SquareBB(from) | toBB;
+    Piece movingPiece                        = Board(from);
+    Piece capturedPiece                      = Board(to);
+    Board(from)                              = Piece::None;
+    Board(to)                                = movingPiece;
+    PiecesBB(PieceTypeOf(movingPiece))      ^= bothBB;
+    PiecesBB(PieceTypeOf(capturedPiece))    ^= toBB;
+    Occupied(ColorOf(movingPiece))          ^= bothBB;
+    Occupied(ColorOf(capturedPiece))        ^= toBB;
+
+    mZobristHash.SwitchPiece(from, movingPiece);
+    mZobristHash.SwitchPiece(to, movingPiece);
+    mZobristHash.SwitchPiece(to, capturedPiece);
+}
+
+void CompactPosition::NullifyEnPassant() {
+    assert(mEnPassant != Square::None);
+    mZobristHash.SwitchEnPassantFile(FileOf(mEnPassant));
+    mEnPassant = Square::None;
+}
+
+void CompactPosition::SetEnPassant(Square square) {
+    assert(mEnPassant == Square::None);
+    mEnPassant = square;
+    mZobristHash.SwitchEnPassantFile(FileOf(square));
+}
+
+void CompactPosition::SwitchSideToMove() {
+    mSideToMove = ~mSideToMove;
+    mZobristHash.SwitchSideToMove();
+}
+
+template <Color color>
+void CompactPosition::UpdateCastlingRights(Square from, Square to) {
+    constexpr Color other           = ~color;
+    constexpr BoardRank MySide      = color == Color::White ? BoardRank::R1 : BoardRank::R8;
+    constexpr BoardRank TheirSide   = other == Color::White ? BoardRank::R1 : BoardRank::R8;
+
+    constexpr Square MyQueenRook    = MakeSquare(BoardFile::A, MySide);
+    constexpr Square MyKingRook     = MakeSquare(BoardFile::H, MySide);
+    constexpr Square MyKing         = MakeSquare(BoardFile::E, MySide);
+    constexpr Square TheirQueenRook = MakeSquare(BoardFile::A, TheirSide);
+    constexpr Square TheirKingRook  = MakeSquare(BoardFile::H, TheirSide);
+    constexpr Square TheirKing      = MakeSquare(BoardFile::E, TheirSide);
+
+    constexpr Bitboard MySideBB     = BB::SquareBB(MyQueenRook) | BB::SquareBB(MyKingRook) | BB::SquareBB(MyKing);
+    constexpr Bitboard TheirSideBB  = BB::SquareBB(TheirQueenRook) | BB::SquareBB(TheirKingRook) | BB::SquareBB(TheirKing);
+    constexpr Bitboard BothBB       = MySideBB | TheirSideBB;
+
+    Bitboard fromBB = BB::SquareBB(from);
+    Bitboard toBB   = BB::SquareBB(to);
+
+    if (mCastlingRights.AnyCastlingAllowed() && (BothBB & (fromBB | toBB))) {
+        mZobristHash.SwitchCastlingRights(mCastlingRights);
+        if (MySideBB & fromBB) {
+            switch (from) {
+            case MyQueenRook:       mCastlingRights.ForbidCastlingQueenside<color>(); break;
+            case MyKingRook:        mCastlingRights.ForbidCastlingKingside<color>(); break;
+            case MyKing:            mCastlingRights.ForbidCastling<color>(); break;
+            default:                break;
+            }
+        }
+        if (TheirSideBB & toBB) {
+            switch (to) {
+            case TheirQueenRook:    mCastlingRights.ForbidCastlingQueenside<other>(); break;
+            case TheirKingRook:     mCastlingRights.ForbidCastlingKingside<other>(); break;
+            case TheirKing:         mCastlingRights.ForbidCastling<other>(); break;
+            default:                break;
+            }
+        }
+        mZobristHash.SwitchCastlingRights(mCastlingRights);
+    }
+}
+
+template <Color color>
+void CompactPosition::UpdateAuxiliaryInfo() {
+    constexpr Color other = ~color;
+
+    Bitboard occupancy          = GetOccupancy();
+    Bitboard queens             = PiecesBB(PieceType::Queen);
+    Bitboard straightSliders    = (queens | PiecesBB(PieceType::Rook)) & GetOccupancy(other);
+    Bitboard diagonalSliders    = (queens | PiecesBB(PieceType::Bishop)) & GetOccupancy(other);
+    Square kingSquare           = GetKingPosition(color);
+    Bitboard occupancyNoKing    = occupancy ^ BB::SquareBB(kingSquare);
+
+    // Attacks of the opponent, sliders see through our king so it cannot step back along a check ray
+    Bitboard attacks = BB::PawnAttacks<other>(GetPiecesBB(other, PieceType::Pawn));
+    attacks |= BB::Attacks<PieceType::King>(GetKingPosition(other));
+    for (Bitboard bb = GetPiecesBB(other, PieceType::Knight); bb; )
+        attacks |= BB::Attacks<PieceType::Knight>(BB::PopLsb(bb));
+    for (Bitboard bb = straightSliders; bb; )
+        attacks |= BB::Attacks<PieceType::Rook>(BB::PopLsb(bb), occupancyNoKing);
+    for (Bitboard bb = diagonalSliders; bb; )
+        attacks |= BB::Attacks<PieceType::Bishop>(BB::PopLsb(bb), occupancyNoKing);
+    mAttacks        = attacks;
+    mCheckSquares   = attacks;
+
+    mKingAttackers = BB::NONE;
+    if (attacks & BB::SquareBB(kingSquare)) {
+        mKingAttackers |= BB::Attacks<PieceType::Rook>(kingSquare, occupancy) & straightSliders;
+        mKingAttackers |= BB::Attacks<PieceType::Bishop>(kingSquare, occupancy) & diagonalSliders;
+        mKingAttackers |= BB::Attacks<PieceType::Knight>(kingSquare) & GetPiecesBB(other, PieceType::Knight);
+        mKingAttackers |= BB::PawnAttacks<color>(kingSquare) & GetPiecesBB(other, PieceType::Pawn);
+    }
+
+    Bitboard occupancyOther     = GetOccupancy(other);
+    Bitboard slideAttackersBB   =
+        (BB::Attacks<PieceType::Rook>(kingSquare, occupancyOther) & straightSliders) |
+        (BB::Attacks<PieceType::Bishop>(kingSquare, occupancyOther) & diagonalSliders);
+    Bitboard pinnedBB           = BB::NONE;
+    while (slideAttackersBB) {
+        Square attackerSq       = BB::PopLsb(slideAttackersBB);
+        Bitboard blockedByBB    = BB::Between(kingSquare, attackerSq) & GetOccupancy(color);
+        if (blockedByBB && !BB::AtLeast2(blockedByBB)) pinnedBB |= blockedByBB;
+    }
+    mPinned = pinnedBB;
+}
+
+void CompactPosition::UpdateAuxiliaryInfo() {
+    if (mSideToMove == Color::White)    UpdateAuxiliaryInfo<Color::White>();
+    else                                UpdateAuxiliaryInfo<Color::Black>();
+}
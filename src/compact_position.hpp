@@ -0,0 +1,90 @@
+#pragma once
+
+#include "types.hpp"
+#include "bitboard.hpp"
+#include "castling_rights.hpp"
+#include "move.hpp"
+#include "position.hpp"
+#include "zobrist_hash.hpp"
+
+#include <string>
+
+/**
+ * Copy-make counterpart of Position
+ * Keeps no move history: DoMove writes the successor into a separate object (typically the next
+ * slot of a per-ply stack), so the state stays small enough to be copied on every move
+ * See https://www.chessprogramming.org/Copy-Make
+ */
+class CompactPosition {
+public:
+    CompactPosition();
+    explicit CompactPosition(const Position& pos);
+    // Throws std::invalid_argument on an illegal fen, as Position does
+    explicit CompactPosition(const char* fen);
+    explicit CompactPosition(const std::string& fen) : CompactPosition(fen.c_str()) {}
+
+    void DoMove(Move move, CompactPosition& next) const;
+
+    Bitboard GetPiecesBB(Color color, PieceType type) const { return mPiecesBB[ToInt(type)] & mOccupied[ToInt(color)]; }
+    Bitboard GetPiecesBB(Piece piece) const                 { return GetPiecesBB(ColorOf(piece), PieceTypeOf(piece)); }
+    Piece GetBoard(Square square) const                     { return mBoard[ToInt(square)]; }
+    Color GetSideToMove() const                             { return mSideToMove; }
+    CastlingRights GetCastlingRights() const                { return mCastlingRights; }
+    Square GetEnPassant() const                             { return mEnPassant; }
+    uint32_t GetReversableHalfMovesCnt() const              { return mReversableHalfMovesCnt; }
+    uint32_t GetMoveNum() const                             { return mMoveNum; }
+
+    Square GetKingPosition(Color color) const   { return BB::Lsb(GetPiecesBB(color, PieceType::King)); }
+
+    Bitboard GetOccupancy(Color color) const    { return mOccupied[ToInt(color)]; }
+    Bitboard GetOccupancy() const               { return mOccupied[ToInt(Color::White)] | mOccupied[ToInt(Color::Black)]; }
+    // Only the attacks of the side not to move are kept
+    Bitboard GetAttacks(Color color) const      { assert(color != mSideToMove); (void)color; return mAttacks; }
+    // Only the pinned pieces of the side to move are kept
+    Bitboard GetPinned(Color color) const       { assert(color == mSideToMove); (void)color; return mPinned; }
+    Bitboard GetKingAttackers() const           { return mKingAttackers; }
+    Bitboard GetCheckSquares() const            { return mCheckSquares; }
+
+    ZobristHash GetZobristHash() const          { return mZobristHash; }
+
+    bool IsCheck() const                        { return mKingAttackers != BB::NONE; }
+    bool IsDoubleCheck() const                  { return BB::AtLeast2(mKingAttackers); }
+
+private:
+    Array<Bitboard, PIECE_TYPE_NUM> mPiecesBB;
+    Array<Bitboard, COLOR_NUM> mOccupied;
+    Bitboard mAttacks                               = BB::NONE;
+    Bitboard mPinned                                = BB::NONE;
+    Bitboard mKingAttackers                         = BB::NONE;
+    Bitboard mCheckSquares                          = BB::NONE;
+    ZobristHash mZobristHash;
+    Array<Piece, SQUARE_NUM> mBoard;
+    Color mSideToMove                               = Color::White;
+    CastlingRights mCastlingRights                  = CastlingRights::ALL;
+    Square mEnPassant                               = Square::None;
+    uint16_t mReversableHalfMovesCnt                = 0;
+    uint16_t mMoveNum                               = 1;
+
+    Bitboard& PiecesBB(PieceType type)              { return mPiecesBB[ToInt(type)]; }
+    Piece& Board(Square square)                     { return mBoard[ToInt(square)]; }
+    Bitboard& Occupied(Color color)                 { return mOccupied[ToInt(color)]; }
+
+    void AddPiece(Piece piece, Square square);
+    void RemovePiece(Square square);
+    void MovePiece(Square from, Square to);
+    void CapturePiece(Square from, Square to);
+
+    void NullifyEnPassant();
+    void SetEnPassant(Square square);
+    void SwitchSideToMove();
+
+    template <Color color>
+    void UpdateCastlingRights(Square from, Square to);
+
+    template <Color color>
+    void UpdateAuxiliaryInfo();
+    void UpdateAuxiliaryInfo();
+
+};
+
+static_assert(sizeof(CompactPosition) <= 192);
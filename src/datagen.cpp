@@ -0,0 +1,203 @@
+#include "datagen.hpp"
+#include "search.hpp"
+#include "move_list.hpp"
+#include "packed_position_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    constexpr int MAX_GAME_PLIES        = 400;      // Adjudicated as a draw
+    constexpr Score WIN_SCORE           = 1500;     // Adjudicated as a win when the search agrees for WIN_PLIES
+    constexpr int WIN_PLIES             = 4;
+    constexpr int DRAW_FROM_PLY         = 80;       // Adjudicated as a draw when the score stays within DRAW_SCORE
+    constexpr Score DRAW_SCORE          = 10;
+    constexpr int DRAW_PLIES            = 12;
+    constexpr size_t FLUSH_RECORDS      = 16384;    // Per worker
+    constexpr int64_t PROGRESS_INTERVAL = 10;       // s
+
+    struct DatagenOptions {
+        const char* output = "data.bin";
+        int threads = 1;
+        uint64_t nodes = 5000;
+        uint64_t positions = 1000000;
+        int randomPlies = 8;
+        Score maxOpeningScore = 300;
+        size_t hashMegabytes = 16;                  // Per worker
+        uint64_t seed = std::random_device()();
+    };
+
+    // Counts the generated data and owns the output file
+    class Generator {
+    public:
+        Generator(const DatagenOptions& options)
+            : mOptions(options), mWriter(options.output), mStart(Clock::now()), mLastProgress(mStart) {}
+
+        bool IsDone() const { return mPositions.load(std::memory_order_relaxed) >= mOptions.positions; }
+        // Counted when a game ends, so that the workers stop close to the requested number of positions
+        void AddGame(uint64_t positions)    { mPositions.fetch_add(positions, std::memory_order_relaxed); mGames.fetch_add(1, std::memory_order_relaxed); }
+        void Write(std::vector<TrainingRecord>& records);
+        void PrintProgress(std::ostream& out);
+
+    private:
+        const DatagenOptions& mOptions;
+        std::mutex mMutex;
+        TrainingRecordWriter mWriter;
+        std::atomic<uint64_t> mPositions = 0;
+        std::atomic<uint64_t> mGames = 0;
+        Clock::time_point mStart;
+        Clock::time_point mLastProgress;
+    };
+
+    void Generator::Write(std::vector<TrainingRecord>& records) {
+        std::lock_guard lock(mMutex);
+        mWriter.Write(records.data(), records.size());
+        records.clear();
+
+        if (Clock::now() - mLastProgress >= std::chrono::seconds(PROGRESS_INTERVAL)) {
+            PrintProgress(std::cerr);
+            mLastProgress = Clock::now();
+        }
+    }
+
+    void Generator::PrintProgress(std::ostream& out) {
+        double seconds = std::max(std::chrono::duration<double>(Clock::now() - mStart).count(), 1e-9);
+        double perHour = mPositions.load() / seconds * 3600;
+        out << std::fixed << std::setprecision(1)
+            << mPositions.load() << " positions from " << mGames.load() << " games in " << seconds << " s: "
+            << perHour / 1e6 << " M positions/hour, " << perHour / mOptions.threads / 1e6 << " M per thread" << std::endl;
+    }
+
+    // Plays random legal moves from the start position; false if the game ends on the way
+    bool PlayRandomOpening(Position& pos, std::mt19937_64& random, int plies) {
+        std::string_view startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+        pos.ParseFEN(startFen);
+        for (int ply = 0; ply < plies; ++ply) {
+            MoveList moveList(pos);
+            if (moveList.size() == 0) return false;
+            pos.DoMove(*(moveList.begin() + random() % moveList.size()));
+        }
+        return MoveList(pos).size() > 0;
+    }
+
+    /**
+     * Plays the game out and records the quiet positions: not in check, best move neither capture nor
+     * promotion, no mate score. Returns the result for White
+     * Until then the result of a record holds the color of its side to move, 1 for White and -1 for Black
+     */
+    int PlayGame(Position& pos, TranspositionTable& table, const SearchLimits& limits, std::vector<TrainingRecord>& records) {
+        const std::atomic<bool> stop = false;
+        int winPlies = 0;                           // Signed: positive while White is winning
+        int drawPlies = 0;
+        for (int ply = 0; ; ++ply) {
+            Color us = pos.GetSideToMove();
+            if (MoveList(pos).size() == 0) return pos.IsCheck() ? (us == Color::White ? -1 : 1) : 0;
+            if (pos.GetReversableHalfMovesCnt() >= 100 || pos.IsRepetition() || pos.IsInsufficientMaterial() || ply >= MAX_GAME_PLIES) return 0;
+
+            SearchResult result = Search(pos, table, limits, stop);
+            int whiteScore = us == Color::White ? result.score : -result.score;
+
+            if (whiteScore >= WIN_SCORE)        winPlies = std::max(winPlies, 0) + 1;
+            else if (whiteScore <= -WIN_SCORE)  winPlies = std::min(winPlies, 0) - 1;
+            else                                winPlies = 0;
+            if (std::abs(winPlies) >= WIN_PLIES) return winPlies > 0 ? 1 : -1;
+            drawPlies = ply >= DRAW_FROM_PLY && std::abs(whiteScore) <= DRAW_SCORE ? drawPlies + 1 : 0;
+            if (drawPlies >= DRAW_PLIES) return 0;
+
+            Move move = result.bestMove;
+            if (!pos.IsCheck() && !move.IsCapture() && !move.IsPromotion() && !IsMateScore(result.score)) {
+                records.push_back({ pos.GetPacked(), result.score, move.GetRaw(), int8_t(us == Color::White ? 1 : -1), {} });
+            }
+            pos.DoMove(move);
+        }
+    }
+
+    void Work(Generator& generator, const DatagenOptions& options, uint64_t seed) {
+        std::mt19937_64 random(seed);
+        TranspositionTable table(options.hashMegabytes);
+        auto pos = std::make_unique<Position>();
+        const std::atomic<bool> stop = false;
+        SearchLimits limits;
+        limits.nodes = options.nodes;
+
+        std::vector<TrainingRecord> buffer;
+        while (!generator.IsDone()) {
+            if (!PlayRandomOpening(*pos, random, options.randomPlies)) continue;
+            table.Clear();
+            // Unbalanced openings mostly produce one-sided games
+            if (std::abs(Search(*pos, table, limits, stop).score) > options.maxOpeningScore) continue;
+
+            size_t gameBegin = buffer.size();
+            int result = PlayGame(*pos, table, limits, buffer);
+            for (size_t i = gameBegin; i < buffer.size(); ++i) buffer[i].result *= result;
+            generator.AddGame(buffer.size() - gameBegin);
+
+            if (buffer.size() >= FLUSH_RECORDS) generator.Write(buffer);
+        }
+        generator.Write(buffer);
+    }
+
+    void PrintUsage(const char* program) {
+        std::cerr
+            << "usage: " << program << " datagen [options]\n"
+            << "  --output <file>          file the TrainingRecord entries are appended to (default: data.bin)\n"
+            << "  --threads <n>            worker threads, each playing its own games (default: 1)\n"
+            << "  --positions <n>          positions to generate (default: 1000000)\n"
+            << "  --nodes <n>              nodes searched per move (default: 5000)\n"
+            << "  --random-plies <n>       random moves at the start of each game (default: 8)\n"
+            << "  --max-opening-score <cp> skip openings the search scores higher (default: 300)\n"
+            << "  --hash <mb>              transposition table size per thread (default: 16)\n"
+            << "  --seed <n>               seed of the random openings (default: random)\n";
+    }
+}
+
+int RunDatagen(int argc, char** argv) {
+    DatagenOptions options;
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--output") == 0 && i + 1 < argc)                    options.output = argv[++i];
+        else if (std::strcmp(arg, "--threads") == 0 && i + 1 < argc)             options.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--positions") == 0 && i + 1 < argc)           options.positions = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--nodes") == 0 && i + 1 < argc)               options.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--random-plies") == 0 && i + 1 < argc)        options.randomPlies = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--max-opening-score") == 0 && i + 1 < argc)   options.maxOpeningScore = Score(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "--hash") == 0 && i + 1 < argc)                options.hashMegabytes = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--seed") == 0 && i + 1 < argc)                options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.threads < 1 || options.nodes < 1 || options.randomPlies < 0 || options.hashMegabytes < 1) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<Generator> generator;
+    try {
+        generator = std::make_unique<Generator>(options);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.threads; ++i) {
+        workers.emplace_back(Work, std::ref(*generator), std::cref(options), options.seed + i);
+    }
+    for (std::thread& worker : workers) worker.join();
+    generator->PrintProgress(std::cerr);
+    return 0;
+}
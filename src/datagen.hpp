@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * Training data generation: worker threads play self-play games with a fixed node count per move
+ * from randomized openings and append the quiet positions, labeled with the search score and the
+ * game result, to a file of TrainingRecord (see packed_position.hpp)
+ * Each worker has its own Position, transposition table and random generator and buffers its
+ * records; full buffers are appended to the shared file under a lock
+ * Returns the process exit code
+ */
+int RunDatagen(int argc, char** argv);
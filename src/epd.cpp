@@ -0,0 +1,142 @@
+#include "epd.hpp"
+
+#include <charconv>
+#include <cstring>
+
+static void SkipSpaces(std::string_view& line) {
+    while (!line.empty() && (line[0] == ' ' || line[0] == '\t')) line.remove_prefix(1);
+}
+
+// Reads one operand: a quoted string or a token up to the next space or ';'
+static FenStatus ReadOperand(std::string_view& line, std::string_view& operand) {
+    if (line[0] == '"') {
+        std::size_t close = line.find('"', 1);
+        if (close == std::string_view::npos) return FenStatus::UnterminatedString;
+        operand = line.substr(1, close - 1);
+        line.remove_prefix(close + 1);
+    } 
+    else {
+        std::size_t length = 0;
+        while (length < line.size() && line[length] != ' ' && line[length] != '\t' && line[length] != ';') ++length;
+        operand = line.substr(0, length);
+        line.remove_prefix(length);
+    }
+    return FenStatus::Ok;
+}
+
+// Reads the operands of one operation up to and including the terminating ';'
+static FenStatus ReadOperands(std::string_view& line, std::string_view* operands, uint8_t maxOperands, uint8_t& operandsNum) {
+    operandsNum = 0;
+    while (true) {
+        SkipSpaces(line);
+        if (line.empty()) return FenStatus::InvalidOperation;
+        if (line[0] == ';') {
+            line.remove_prefix(1);
+            return FenStatus::Ok;
+        }
+
+        std::string_view operand;
+        FenStatus status = ReadOperand(line, operand);
+        if (status != FenStatus::Ok) return status;
+        if (operands) {
+            if (operandsNum == maxOperands) return FenStatus::TooManyOperands;
+            operands[operandsNum] = operand;
+        }
+        ++operandsNum;
+    }
+}
+
+// Reads the single numeric operand of an operation
+static FenStatus ReadNumber(std::string_view& line, uint64_t& number) {
+    std::string_view operand;
+    uint8_t operandsNum;
+    FenStatus status = ReadOperands(line, &operand, 1, operandsNum);
+    if (status != FenStatus::Ok) return status;
+
+    auto [end, error] = std::from_chars(operand.data(), operand.data() + operand.size(), number);
+    if (operandsNum != 1 || error != std::errc() || end != operand.data() + operand.size()) return FenStatus::InvalidOperation;
+    return FenStatus::Ok;
+}
+
+// Perft results are written as D<depth> <nodes>, e.g. "D5 4865609;"
+static bool ParsePerftDepth(std::string_view opcode, uint8_t& depth) {
+    if (opcode.size() < 2 || opcode.size() > 3 || opcode[0] != 'D') return false;
+    auto [end, error] = std::from_chars(opcode.data() + 1, opcode.data() + opcode.size(), depth);
+    return error == std::errc() && end == opcode.data() + opcode.size() && depth > 0;
+}
+
+FenStatus ParseEPD(std::string_view line, Position& pos, EpdRecord& record) {
+    record.bestMovesNum     = 0;
+    record.avoidMovesNum    = 0;
+    record.id               = {};
+    record.comment          = {};
+    record.perftDepth       = 0;
+    record.perftNodes       = 0;
+    record.nps              = 0;
+
+    FenStatus status = pos.ParseFEN(line);
+    if (status != FenStatus::Ok) return status;
+
+    while (true) {
+        SkipSpaces(line);
+        if (line.empty()) return FenStatus::Ok;
+
+        std::size_t opcodeLength = 0;
+        while (opcodeLength < line.size() && line[opcodeLength] != ' ' && line[opcodeLength] != ';') ++opcodeLength;
+        std::string_view opcode = line.substr(0, opcodeLength);
+        line.remove_prefix(opcodeLength);
+
+        uint8_t operandsNum;
+        uint8_t perftDepth;
+        if (opcode == "bm") {
+            status = ReadOperands(line, record.bestMoves.data(), EpdRecord::MAX_MOVES, record.bestMovesNum);
+        }
+        else if (opcode == "am") {
+            status = ReadOperands(line, record.avoidMoves.data(), EpdRecord::MAX_MOVES, record.avoidMovesNum);
+        }
+        else if (opcode == "id") {
+            status = ReadOperands(line, &record.id, 1, operandsNum);
+        }
+        else if (opcode == "c0") {
+            status = ReadOperands(line, &record.comment, 1, operandsNum);
+        }
+        else if (opcode == "nps") {
+            status = ReadNumber(line, record.nps);
+        }
+        else if (ParsePerftDepth(opcode, perftDepth)) {
+            uint64_t nodes;
+            status = ReadNumber(line, nodes);
+            if (status == FenStatus::Ok && perftDepth > record.perftDepth) {
+                record.perftDepth = perftDepth;
+                record.perftNodes = nodes;
+            }
+        }
+        else {
+            status = ReadOperands(line, nullptr, 0, operandsNum);
+        }
+        if (status != FenStatus::Ok) return status;
+    }
+}
+
+EpdFileReader::EpdFileReader(const std::string& path) : mFile(path) {
+    mCursor = mFile.GetData();
+    mEnd    = mCursor + mFile.GetSize();
+}
+
+bool EpdFileReader::Next(Position& pos, EpdRecord& record, FenStatus& status) {
+    while (mCursor < mEnd) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(mCursor, '\n', mEnd - mCursor));
+        if (!lineEnd) lineEnd = mEnd;
+
+        mLine   = std::string_view(mCursor, lineEnd - mCursor);
+        mCursor = lineEnd + (lineEnd < mEnd);
+        ++mLineNumber;
+
+        while (!mLine.empty() && (mLine.back() == '\r' || mLine.back() == ' ')) mLine.remove_suffix(1);
+        if (mLine.empty() || mLine[0] == '#') continue;
+
+        status = ParseEPD(mLine, pos, record);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "position.hpp"
+#include "mapped_file.hpp"
+
+#include <string>
+#include <string_view>
+
+/**
+ * Operations of an EPD record
+ * All views point into the parsed line; moves are kept as written (SAN)
+ * See https://www.chessprogramming.org/Extended_Position_Description
+ */
+struct EpdRecord {
+    static constexpr uint8_t MAX_MOVES = 16;
+
+    Array<std::string_view, MAX_MOVES> bestMoves;   // bm
+    Array<std::string_view, MAX_MOVES> avoidMoves;  // am
+    uint8_t bestMovesNum = 0;
+    uint8_t avoidMovesNum = 0;
+    std::string_view id;                            // id
+    std::string_view comment;                       // c0
+    uint8_t perftDepth = 0;                         // D<depth> <nodes>, the deepest one is kept
+    uint64_t perftNodes = 0;
+    uint64_t nps = 0;                               // nps, not a standard opcode (see bench/perft_baseline.epd)
+};
+
+// Parses a FEN or EPD line into pos and record without throwing or allocating
+// Unknown opcodes are skipped
+FenStatus ParseEPD(std::string_view line, Position& pos, EpdRecord& record);
+
+/**
+ * Streams the lines of a memory-mapped FEN or EPD file
+ */
+class EpdFileReader {
+public:
+    explicit EpdFileReader(const std::string& path);
+
+    // Parses the next non-empty line not starting with '#' into pos and record; returns false at the end of the file
+    bool Next(Position& pos, EpdRecord& record, FenStatus& status);
+
+    std::size_t GetLineNumber() const   { return mLineNumber; }
+    std::string_view GetLine() const    { return mLine; }
+
+private:
+    MappedFile mFile;
+    const char* mCursor;
+    const char* mEnd;
+    std::string_view mLine;
+    std::size_t mLineNumber = 0;
+};
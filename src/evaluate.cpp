@@ -0,0 +1,24 @@
+#include "evaluate.hpp"
+#include "profile.hpp"
+
+static constexpr Array<Score, PIECE_TYPE_NUM> PieceValues = {
+    320,    // Knight
+    330,    // Bishop
+    500,    // Rook
+    900,    // Queen
+    0,      // King
+    100     // Pawn
+};
+
+// Material balance from the point of view of the side to move
+Score Evaluate(const Position& pos) {
+    PROFILE_SCOPE(Evaluate);
+    Color us = pos.GetSideToMove();
+    Color them = ~us;
+    int score = 0;
+    for (PieceType type = PieceType::Knight; type <= PieceType::Pawn; ++type) {
+        int balance = BB::Count1s(pos.GetPiecesBB(us, type)) - BB::Count1s(pos.GetPiecesBB(them, type));
+        score += balance * PieceValues[ToInt(type)];
+    }
+    return score;
+}
@@ -1,7 +1,41 @@
-#include "bitboard.hpp"
-#include "zobrist_hash.hpp"
+#include "uci.hpp"
+#include "bench.hpp"
+#include "batch.hpp"
+#include "datagen.hpp"
+#include "polyglot_book.hpp"
 
-int main() {
-    BB::Init();
-    ZobristHash::Init();
-}
\ No newline at end of file
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    // chess-engine bench [depth]
+    if (argc > 1 && std::strcmp(argv[1], "bench") == 0) {
+        int depth = argc > 2 ? std::atoi(argv[2]) : BENCH_DEPTH;
+        if (depth < 1 || depth >= MAX_PLY) {
+            std::cerr << "usage: " << argv[0] << " bench [depth]" << std::endl;
+            return 1;
+        }
+        Bench(std::cout, depth);
+        return 0;
+    }
+
+    // chess-engine batch [options]
+    if (argc > 1 && std::strcmp(argv[1], "batch") == 0) {
+        return RunBatch(argc, argv);
+    }
+
+    // chess-engine datagen [options]
+    if (argc > 1 && std::strcmp(argv[1], "datagen") == 0) {
+        return RunDatagen(argc, argv);
+    }
+
+    // chess-engine bookkeys
+    if (argc > 1 && std::strcmp(argv[1], "bookkeys") == 0) {
+        return CheckPolyglotKeys(std::cout) ? 0 : 1;
+    }
+
+    UCI uci;
+    uci.Loop(std::cin, std::cout);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Read-only memory mapping of a whole file
+ * Requires a POSIX system
+ */
+class MappedFile {
+public:
+    // Read-ahead hint for the kernel
+    enum class Access {
+        Sequential,     // Read front to back, pages ahead of the reader are prefetched
+        Random          // Searched, prefetching would mostly read pages that are never used
+    };
+
+    explicit MappedFile(const std::string& path, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* GetData() const     { return mData; }
+    std::size_t GetSize() const     { return mSize; }
+
+private:
+    const char* mData   = nullptr;
+    std::size_t mSize   = 0;
+};
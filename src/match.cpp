@@ -0,0 +1,552 @@
+#include "uci_process.hpp"
+#include "uci.hpp"
+#include "epd.hpp"
+#include "san.hpp"
+#include "move_list.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plays games between two UCI engines run as local processes, a given number of games at a time,
+// and tracks the score, the Elo difference and optionally a sequential probability ratio test.
+// Each opening is played twice with the colors reversed.
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+static constexpr int64_t READY_TIMEOUT = 10000;    // ms
+
+struct EngineConfig {
+    std::string name;
+    std::string command;
+    std::vector<std::pair<std::string, std::string>> options;   // setoption name <first> value <second>
+};
+
+// Exactly one kind of limit is used, in this order
+struct TimeControl {
+    int64_t time = 0;               // ms per game
+    int64_t increment = 0;          // ms per move
+    int64_t moveTime = 0;           // ms
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t margin = 50;            // ms an engine may exceed its clock
+    int64_t timeout = 60000;        // ms to wait for a move under a depth or node limit
+};
+
+// A value of 0 disables the rule
+struct Adjudication {
+    int resignMoves = 0;            // Both engines agree on a score of at least resignScore for one side
+    int resignScore = 0;            // cp
+    int drawMoveNumber = 0;         // From this move number on, both engines report at most drawScore
+    int drawMoves = 0;
+    int drawScore = 0;              // cp
+    int maxMoves = 0;
+};
+
+struct SprtConfig {
+    bool enabled = false;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+struct Options {
+    std::vector<EngineConfig> engines;
+    TimeControl tc;
+    Adjudication adjudication;
+    SprtConfig sprt;
+    int games = 100;
+    int concurrency = 1;
+    const char* openingsPath = nullptr;
+    const char* pgnPath = nullptr;
+};
+
+struct GameRecord {
+    int whiteEngine;
+    std::string fen;
+    std::vector<Move> moves;
+    const char* result;             // 1-0, 0-1 or 1/2-1/2
+    std::string reason;
+};
+
+// Score of the first engine as wins, draws and losses
+struct MatchScore {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int Games() const       { return wins + draws + losses; }
+    double Mean() const     { return (wins + draws / 2.0) / Games(); }
+    // Per game variance of the game score
+    double Variance() const {
+        double mean = Mean();
+        return (wins * (1 - mean) * (1 - mean) + draws * (0.5 - mean) * (0.5 - mean) + losses * mean * mean) / Games();
+    }
+};
+
+static double EloToScore(double elo)    { return 1 / (1 + std::pow(10, -elo / 400)); }
+static double ScoreToElo(double score)  { return -400 * std::log10(1 / score - 1); }
+
+/**
+ * Log-likelihood ratio of the Elo difference being elo1 rather than elo0, with the normal approximation
+ * of the game score (generalized SPRT, https://www.chessprogramming.org/Sequential_Probability_Ratio_Test)
+ */
+static double LogLikelihoodRatio(const MatchScore& score, double elo0, double elo1) {
+    if (score.Games() == 0) return 0;
+    double variance = score.Variance();
+    if (variance <= 0) return 0;
+    double s0 = EloToScore(elo0), s1 = EloToScore(elo1);
+    return score.Games() * (s1 - s0) * (2 * score.Mean() - s0 - s1) / (2 * variance);
+}
+
+namespace {
+    class Match {
+    public:
+        Match(const Options& options, std::vector<std::string> openings, std::ostream* pgn)
+            : mOptions(options), mOpenings(std::move(openings)), mPgn(pgn), mReplay(std::make_unique<Position>()) {}
+
+        // Hands out the game numbers; false once all are played or the SPRT has decided
+        bool NextGame(int& index);
+        const std::string& GetOpening(int index) const { return mOpenings[index / 2 % mOpenings.size()]; }
+        void Finish(int index, const GameRecord& game);
+        // After an engine failure no further games are started and the match fails
+        void Abort() { mFailed.store(true); mStop.store(true); }
+        bool HasFailed() const { return mFailed.load(); }
+
+    private:
+        const Options& mOptions;
+        std::vector<std::string> mOpenings;
+        std::ostream* mPgn;
+
+        std::atomic<bool> mStop = false;
+        std::atomic<bool> mFailed = false;
+        std::mutex mMutex;
+        int mNextGame = 0;
+        MatchScore mScore;
+        bool mDecided = false;
+        std::unique_ptr<Position> mReplay;  // To write the moves in SAN
+
+        void WritePgn(int index, const GameRecord& game);
+    };
+
+    bool Match::NextGame(int& index) {
+        std::lock_guard lock(mMutex);
+        if (mStop.load() || mNextGame >= mOptions.games) return false;
+        index = mNextGame++;
+        return true;
+    }
+
+    void Match::Finish(int index, const GameRecord& game) {
+        std::lock_guard lock(mMutex);
+        const std::string& first = mOptions.engines[0].name;
+        const std::string& second = mOptions.engines[1].name;
+        bool firstIsWhite = game.whiteEngine == 0;
+
+        if (std::strcmp(game.result, "1/2-1/2") == 0)           ++mScore.draws;
+        else if ((std::strcmp(game.result, "1-0") == 0) == firstIsWhite)   ++mScore.wins;
+        else                                                    ++mScore.losses;
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Finished game " << index + 1 << " (" << (firstIsWhite ? first : second) << " vs "
+                  << (firstIsWhite ? second : first) << "): " << game.result << " {" << game.reason << "}\n"
+                  << "Score of " << first << " vs " << second << ": " << mScore.wins << " - " << mScore.losses
+                  << " - " << mScore.draws << "  [" << mScore.Mean() << "] " << mScore.Games() << '\n';
+
+        // 95% confidence interval of the mean score, mapped to Elo
+        double mean = mScore.Mean();
+        double margin = 1.96 * std::sqrt(mScore.Variance() / mScore.Games());
+        std::cout << std::setprecision(1);
+        if (mean > 0 && mean < 1) {
+            double low = ScoreToElo(std::max(mean - margin, 1e-6)), high = ScoreToElo(std::min(mean + margin, 1 - 1e-6));
+            std::cout << "Elo difference: " << ScoreToElo(mean) << " +/- " << (high - low) / 2 << '\n';
+        }
+
+        if (mOptions.sprt.enabled) {
+            const SprtConfig& sprt = mOptions.sprt;
+            double llr = LogLikelihoodRatio(mScore, sprt.elo0, sprt.elo1);
+            double lower = std::log(sprt.beta / (1 - sprt.alpha)), upper = std::log((1 - sprt.beta) / sprt.alpha);
+            std::cout << std::setprecision(2) << "SPRT: llr " << llr << " (" << lower << ", " << upper << "), elo0 "
+                      << sprt.elo0 << " elo1 " << sprt.elo1;
+            // Games still running when the test decides are reported but do not change the decision
+            if (!mDecided && (llr >= upper || llr <= lower)) {
+                std::cout << (llr >= upper ? " - H1 was accepted" : " - H0 was accepted");
+                mDecided = true;
+                mStop.store(true);
+            }
+            std::cout << '\n';
+        }
+        std::cout << std::flush;
+
+        if (mPgn) WritePgn(index, game);
+    }
+
+    void Match::WritePgn(int index, const GameRecord& game) {
+        const std::string& white = mOptions.engines[game.whiteEngine].name;
+        const std::string& black = mOptions.engines[1 - game.whiteEngine].name;
+        *mPgn << "[Event \"match\"]\n"
+              << "[Round \"" << index + 1 << "\"]\n"
+              << "[White \"" << white << "\"]\n"
+              << "[Black \"" << black << "\"]\n"
+              << "[Result \"" << game.result << "\"]\n";
+        if (game.fen != START_FEN) *mPgn << "[FEN \"" << game.fen << "\"]\n[SetUp \"1\"]\n";
+        *mPgn << "[Termination \"" << game.reason << "\"]\n\n";
+
+        std::string_view fen = game.fen;
+        mReplay->ParseFEN(fen);
+        size_t lineLength = 0;
+        auto write = [&](const std::string& token) {
+            if (lineLength + token.size() + 1 > 80) {
+                *mPgn << '\n';
+                lineLength = 0;
+            }
+            else if (lineLength) {
+                *mPgn << ' ';
+                ++lineLength;
+            }
+            *mPgn << token;
+            lineLength += token.size();
+        };
+        for (size_t i = 0; i < game.moves.size(); ++i) {
+            Color us = mReplay->GetSideToMove();
+            if (us == Color::White || i == 0) write(std::to_string(mReplay->GetMoveNum()) + (us == Color::White ? "." : "..."));
+            write(ToSAN(*mReplay, game.moves[i]));
+            mReplay->DoMove(game.moves[i]);
+        }
+        write(game.result);
+        *mPgn << "\n\n" << std::flush;
+    }
+
+    // Plays the side to move of one game and keeps its clock
+    struct Player {
+        UciProcess* engine;
+        int64_t clock;
+    };
+
+    // Whether the position occurred twice before since the last irreversible move
+    bool IsThreefoldRepetition(const Position& pos, const std::vector<uint64_t>& hashes) {
+        size_t plies = std::min<size_t>(pos.GetReversableHalfMovesCnt(), hashes.size() - 1);
+        int repetitions = 0;
+        for (size_t ply = 2; ply <= plies; ply += 2) {
+            repetitions += hashes[hashes.size() - 1 - ply] == hashes.back();
+        }
+        return repetitions >= 2;
+    }
+
+    // Score of the side to move in the last "info ... score" line, converted to cp
+    bool ParseScore(const std::string& line, int& score) {
+        size_t at = line.find(" score ");
+        if (at == std::string::npos) return false;
+        std::istringstream stream(line.substr(at + 7));
+        std::string kind;
+        int value;
+        if (!(stream >> kind >> value)) return false;
+        if (kind == "cp")           score = value;
+        else if (kind == "mate")    score = value > 0 ? SCORE_MATE - value : -SCORE_MATE - value;
+        else                        return false;
+        return true;
+    }
+
+    std::string GoCommand(const TimeControl& tc, const Array<Player, COLOR_NUM>& players) {
+        if (tc.time) {
+            return "go wtime " + std::to_string(std::max<int64_t>(players[ToInt(Color::White)].clock, 1))
+                 + " btime " + std::to_string(std::max<int64_t>(players[ToInt(Color::Black)].clock, 1))
+                 + " winc " + std::to_string(tc.increment) + " binc " + std::to_string(tc.increment);
+        }
+        if (tc.moveTime)    return "go movetime " + std::to_string(tc.moveTime);
+        if (tc.depth)       return "go depth " + std::to_string(tc.depth);
+        return "go nodes " + std::to_string(tc.nodes);
+    }
+
+    void PlayGame(Position& pos, Array<Player, COLOR_NUM> players, const Options& options, GameRecord& game) {
+        const TimeControl& tc = options.tc;
+        const Adjudication& adjudication = options.adjudication;
+        auto end = [&](Color winner, bool draw, std::string reason) {
+            game.result = draw ? "1/2-1/2" : winner == Color::White ? "1-0" : "0-1";
+            game.reason = std::move(reason);
+        };
+        auto loses = [&](Color loser, const std::string& why) {
+            end(~loser, false, std::string(loser == Color::White ? "White" : "Black") + " " + why);
+        };
+
+        std::string_view fen = game.fen;
+        pos.ParseFEN(fen);
+        std::vector<uint64_t> hashes = { pos.GetZobristHash() };
+        std::string position = "position fen " + game.fen + " moves";
+
+        // Also skips what an engine still sent for the previous game, e.g. a move after losing on time
+        for (Player& player : players) {
+            player.engine->Send("ucinewgame");
+            if (!player.engine->WaitReady(READY_TIMEOUT)) throw std::runtime_error(player.engine->GetName() + " is not ready for a new game");
+        }
+
+        Array<int, COLOR_NUM> winningPlies = {};    // Consecutive plies on which the engines agree that the side wins
+        int drawPlies = 0;
+        std::string line;
+        while (true) {
+            Color us = pos.GetSideToMove();
+            if (MoveList(pos).size() == 0) {
+                if (pos.IsCheck())  loses(us, "is mated");
+                else                end(us, true, "stalemate");
+                return;
+            }
+            if (pos.GetReversableHalfMovesCnt() >= 100)     return end(us, true, "fifty move rule");
+            if (IsThreefoldRepetition(pos, hashes))         return end(us, true, "threefold repetition");
+            if (pos.IsInsufficientMaterial())              return end(us, true, "insufficient material");
+            if (game.moves.size() + 1 >= Position::MAX_HALF_MOVES || (adjudication.maxMoves && int(game.moves.size()) >= 2 * adjudication.maxMoves)) {
+                return end(us, true, "move limit");
+            }
+
+            Player& player = players[ToInt(us)];
+            player.engine->Send(position);
+            auto start = Clock::now();
+            player.engine->Send(GoCommand(tc, players));
+
+            // A lost engine is detected by the clock, or after a generous wait without a clock
+            int64_t timeout = tc.time ? player.clock + tc.margin : tc.moveTime ? tc.moveTime * 2 + 5000 : tc.timeout;
+            bool hasScore = false;
+            int score = 0;
+            Move move = Move::NewNone();
+            bool answered = false;
+            auto left = [&] {
+                return std::max<int64_t>(timeout - std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count(), 0);
+            };
+            while (player.engine->ReadLine(line, left())) {
+                if (line.rfind("info", 0) == 0) {
+                    hasScore |= ParseScore(line, score);
+                }
+                else if (line.rfind("bestmove ", 0) == 0) {
+                    std::istringstream words(line.substr(9));
+                    std::string uci;
+                    words >> uci;
+                    move = ParseUCIMove(pos, uci);
+                    answered = true;
+                    break;
+                }
+            }
+            int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+            if (tc.time && (!answered || elapsed > player.clock + tc.margin)) return loses(us, "loses on time");
+            if (!answered)                  return loses(us, "stopped responding");
+            if (move == Move::NewNone())    return loses(us, "made an illegal move");
+            if (tc.time) player.clock += tc.increment - elapsed;
+
+            pos.DoMove(move);
+            game.moves.push_back(move);
+            hashes.push_back(pos.GetZobristHash());
+            position += ' ';
+            position += move.ToUCI();
+
+            // Score adjudication needs the scores of both engines on consecutive plies
+            if (!hasScore) {
+                winningPlies = {};
+                drawPlies = 0;
+                continue;
+            }
+            int whiteScore = us == Color::White ? score : -score;
+            winningPlies[ToInt(Color::White)] = whiteScore >= adjudication.resignScore ? winningPlies[ToInt(Color::White)] + 1 : 0;
+            winningPlies[ToInt(Color::Black)] = -whiteScore >= adjudication.resignScore ? winningPlies[ToInt(Color::Black)] + 1 : 0;
+            drawPlies = std::abs(whiteScore) <= adjudication.drawScore && int(pos.GetMoveNum()) >= adjudication.drawMoveNumber ? drawPlies + 1 : 0;
+
+            if (adjudication.resignMoves) {
+                for (Color color : { Color::White, Color::Black }) {
+                    if (winningPlies[ToInt(color)] >= 2 * adjudication.resignMoves) return loses(~color, "resigns (adjudication)");
+                }
+            }
+            if (adjudication.drawMoves && drawPlies >= 2 * adjudication.drawMoves) return end(us, true, "draw by adjudication");
+        }
+    }
+
+    void Work(Match& match, const Options& options) {
+        try {
+            Array<std::unique_ptr<UciProcess>, 2> engines;
+            for (int i = 0; i < 2; ++i) {
+                engines[i] = std::make_unique<UciProcess>(options.engines[i].command);
+                for (const auto& [name, value] : options.engines[i].options) {
+                    engines[i]->Send("setoption name " + name + " value " + value);
+                }
+                if (!engines[i]->WaitReady(READY_TIMEOUT)) throw std::runtime_error("No readyok from " + options.engines[i].command);
+            }
+
+            auto pos = std::make_unique<Position>();
+            int index;
+            while (match.NextGame(index)) {
+                GameRecord game;
+                game.whiteEngine = index % 2;
+                game.fen = match.GetOpening(index);
+                Array<Player, COLOR_NUM> players;
+                players[ToInt(Color::White)] = { engines[game.whiteEngine].get(), options.tc.time };
+                players[ToInt(Color::Black)] = { engines[1 - game.whiteEngine].get(), options.tc.time };
+                PlayGame(*pos, players, options, game);
+                match.Finish(index, game);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            match.Abort();
+        }
+    }
+
+    // Calls onValue for every key=value argument following argv[i]; false on a malformed one
+    template <typename Callback>
+    bool ReadKeyValues(int& i, int argc, char** argv, Callback onValue) {
+        while (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) {
+            std::string_view arg = argv[++i];
+            size_t equals = arg.find('=');
+            if (equals == std::string_view::npos || !onValue(arg.substr(0, equals), std::string(arg.substr(equals + 1)))) return false;
+        }
+        return true;
+    }
+
+    // Seconds with an optional increment, e.g. 10+0.1
+    bool ParseTimeControl(const char* arg, TimeControl& tc) {
+        char* end;
+        tc.time = std::llround(std::strtod(arg, &end) * 1000);
+        if (*end == '+') tc.increment = std::llround(std::strtod(end + 1, &end) * 1000);
+        return *end == '\0' && tc.time > 0 && tc.increment >= 0;
+    }
+
+    std::vector<std::string> ReadOpenings(const char* path) {
+        std::vector<std::string> openings;
+        EpdFileReader reader(path);
+        auto pos = std::make_unique<Position>();
+        EpdRecord record;
+        FenStatus status;
+        while (reader.Next(*pos, record, status)) {
+            if (status != FenStatus::Ok) {
+                throw std::runtime_error(std::string(path) + ":" + std::to_string(reader.GetLineNumber()) + ": " + ToString(status));
+            }
+            openings.push_back(pos->GetFEN());
+        }
+        if (openings.empty()) throw std::runtime_error(std::string("No positions in ") + path);
+        return openings;
+    }
+
+    void PrintUsage(const char* program) {
+        std::cerr
+            << "usage: " << program << " --engine cmd=<command> [name=<name>] [option.<name>=<value>...]\n"
+            << "       --engine ... [options]\n"
+            << "  --tc <seconds>[+<increment>]       time control per game, e.g. 10+0.1\n"
+            << "  --movetime <ms> | --depth <n> | --nodes <n>   limit per move instead of a time control\n"
+            << "  --timemargin <ms>                  time an engine may exceed its clock (default: 50)\n"
+            << "  --timeout <ms>                     wait for a move under --depth or --nodes (default: 60000)\n"
+            << "  --games <n>                        games to play (default: 100)\n"
+            << "  --concurrency <n>                  games played at the same time (default: 1)\n"
+            << "  --openings <file>                  FEN or EPD start positions, each played with both colors\n"
+            << "  --pgn <file>                       write the games to a PGN file\n"
+            << "  --sprt elo0=<e> elo1=<e> [alpha=<a>] [beta=<b>]   stop once the test decides (default: 0 5 0.05 0.05)\n"
+            << "  --resign movecount=<n> score=<cp>  adjudicate a loss when both engines agree for n moves\n"
+            << "  --draw movenumber=<n> movecount=<n> score=<cp>    adjudicate a draw when both scores stay small\n"
+            << "  --maxmoves <n>                     adjudicate a draw after n moves\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--engine") == 0) {
+            EngineConfig& engine = options.engines.emplace_back();
+            valid = ReadKeyValues(i, argc, argv, [&](std::string_view key, std::string value) {
+                if (key == "cmd")                   engine.command = value;
+                else if (key == "name")             engine.name = value;
+                else if (key.rfind("option.", 0) == 0) engine.options.emplace_back(key.substr(7), value);
+                else return false;
+                return true;
+            });
+        }
+        else if (std::strcmp(arg, "--tc") == 0 && i + 1 < argc)          valid = ParseTimeControl(argv[++i], options.tc);
+        else if (std::strcmp(arg, "--movetime") == 0 && i + 1 < argc)    options.tc.moveTime = std::atoll(argv[++i]);
+        else if (std::strcmp(arg, "--depth") == 0 && i + 1 < argc)       options.tc.depth = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--nodes") == 0 && i + 1 < argc)       options.tc.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--timemargin") == 0 && i + 1 < argc)  options.tc.margin = std::atoll(argv[++i]);
+        else if (std::strcmp(arg, "--timeout") == 0 && i + 1 < argc)     options.tc.timeout = std::atoll(argv[++i]);
+        else if (std::strcmp(arg, "--games") == 0 && i + 1 < argc)       options.games = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--concurrency") == 0 && i + 1 < argc) options.concurrency = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--openings") == 0 && i + 1 < argc)    options.openingsPath = argv[++i];
+        else if (std::strcmp(arg, "--pgn") == 0 && i + 1 < argc)         options.pgnPath = argv[++i];
+        else if (std::strcmp(arg, "--maxmoves") == 0 && i + 1 < argc)    options.adjudication.maxMoves = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--sprt") == 0) {
+            options.sprt.enabled = true;
+            valid = ReadKeyValues(i, argc, argv, [&](std::string_view key, std::string value) {
+                if (key == "elo0")          options.sprt.elo0 = std::atof(value.c_str());
+                else if (key == "elo1")     options.sprt.elo1 = std::atof(value.c_str());
+                else if (key == "alpha")    options.sprt.alpha = std::atof(value.c_str());
+                else if (key == "beta")     options.sprt.beta = std::atof(value.c_str());
+                else return false;
+                return true;
+            });
+        }
+        else if (std::strcmp(arg, "--resign") == 0) {
+            valid = ReadKeyValues(i, argc, argv, [&](std::string_view key, std::string value) {
+                if (key == "movecount")     options.adjudication.resignMoves = std::atoi(value.c_str());
+                else if (key == "score")    options.adjudication.resignScore = std::atoi(value.c_str());
+                else return false;
+                return true;
+            });
+        }
+        else if (std::strcmp(arg, "--draw") == 0) {
+            valid = ReadKeyValues(i, argc, argv, [&](std::string_view key, std::string value) {
+                if (key == "movenumber")    options.adjudication.drawMoveNumber = std::atoi(value.c_str());
+                else if (key == "movecount")options.adjudication.drawMoves = std::atoi(value.c_str());
+                else if (key == "score")    options.adjudication.drawScore = std::atoi(value.c_str());
+                else return false;
+                return true;
+            });
+        }
+        else {
+            valid = false;
+        }
+    }
+
+    const TimeControl& tc = options.tc;
+    const SprtConfig& sprt = options.sprt;
+    valid = valid && options.engines.size() == 2 && options.games > 0 && options.concurrency > 0 && tc.margin >= 0 && tc.timeout > 0
+        && (tc.time > 0) + (tc.moveTime > 0) + (tc.depth > 0) + (tc.nodes > 0) == 1
+        && (!sprt.enabled || (sprt.elo0 < sprt.elo1 && sprt.alpha > 0 && sprt.alpha < 1 && sprt.beta > 0 && sprt.beta < 1));
+    for (EngineConfig& engine : options.engines) {
+        valid = valid && !engine.command.empty();
+        if (engine.name.empty()) engine.name = engine.command;
+    }
+    if (!valid) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (options.engines[0].name == options.engines[1].name) options.engines[1].name += " (2)";
+
+    std::vector<std::string> openings = { START_FEN };
+    std::ofstream pgn;
+    try {
+        if (options.openingsPath) openings = ReadOpenings(options.openingsPath);
+        if (options.pgnPath) {
+            pgn.open(options.pgnPath);
+            if (!pgn) throw std::runtime_error(std::string("Cannot write ") + options.pgnPath);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // A crashed engine must show up as a failed write, not end the match
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Match match(options, std::move(openings), pgn.is_open() ? &pgn : nullptr);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.concurrency; ++i) workers.emplace_back(Work, std::ref(match), std::cref(options));
+    for (std::thread& worker : workers) worker.join();
+    return match.HasFailed() ? 1 : 0;
+}
@@ -2,6 +2,7 @@
 
 #include "types.hpp"
 #include <cstdint>
+#include <string>
 
 // https://www.chessprogramming.org/Encoding_Moves
 class Move {
@@ -69,6 +70,20 @@ public:
     constexpr bool IsDoublePawnPush() const       { return (mMove & FLAGS_MASK) == DOUBLE_PAWN_FLAG; }
 
     constexpr bool IsQuiet() const                { return (mMove & FLAGS_EXCEPT_FIRST) == 0; }
+
+    constexpr bool operator==(const Move& other) const = default;
+
+    // Long algebraic notation as used by UCI, e.g. e2e4, e7e8q, e1g1 for castling
+    std::string ToUCI() const;
+
+    // The 16 bit encoding, e.g. to store the move in a hash table entry
+    static constexpr Move FromRaw(uint16_t raw)   { return Move(raw); }
+    constexpr uint16_t GetRaw() const             { return mMove; }
+
+    // The 4 flag bits of the encoding, which tell the kind of the move (e.g. to index a dispatch table)
+    static constexpr int FLAGS_SHIFT                = 12;
+    static constexpr int FLAGS_NUM                  = 16;
+    constexpr int GetFlags() const                { return mMove >> FLAGS_SHIFT; }
     
 
 private:
@@ -77,7 +92,7 @@ private:
     static constexpr uint16_t FROM_MASK             = (1 << 6) - 1;
     static constexpr uint16_t TO_MASK               = (1 << 6) - 1;
 
-    static constexpr uint16_t FLAGS_MASK            = ((1 << 4) - 1) << 12;
+    static constexpr uint16_t FLAGS_MASK            = (FLAGS_NUM - 1) << FLAGS_SHIFT;
     static constexpr uint16_t FLAGS_EXCEPT_FIRST    = ((1 << 3) - 1) << 13;
 
     static constexpr uint16_t DOUBLE_PAWN_FLAG      = 1 << 12;
@@ -98,4 +113,16 @@ private:
 
     constexpr Move(uint16_t move) { mMove = move; }
 
-};
\ No newline at end of file
+};
+
+inline std::string Move::ToUCI() const {
+    if (*this == NewNone()) return "0000";
+    Square from = GetFrom();
+    Square to = GetTo();
+    std::string uci = {
+        char('a' + ToInt(FileOf(from))), char('1' + ToInt(RankOf(from))),
+        char('a' + ToInt(FileOf(to))), char('1' + ToInt(RankOf(to)))
+    };
+    if (IsPromotion()) uci += "nbrq"[ToInt(GetPromotionType())];
+    return uci;
+}
@@ -1,24 +1,47 @@
 #include "move_generation.hpp"
+#include "profile.hpp"
 
-template <Color This>
-static Move* GenerateNormalKingMoves(Move* list, const Position& pos, Bitboard allowedTargets) {
-    Square from = pos.GetKingPosition(This);
-    Bitboard movesBB = BB::Attacks<PieceType::King>(from);
-    movesBB &= ~pos.GetCheckSquares(); // King may not move into check
-    movesBB &= allowedTargets;
+// Adds a normal move to every target, allowedTargets has already been restricted according to Type
+template <GenType Type, typename Pos>
+static Move* AddPieceMoves(Move* list, const Pos& pos, Square from, Bitboard movesBB) {
     while (movesBB) {
         Square to = BB::PopLsb(movesBB);
-        if (pos.GetBoard(to) == Piece::None) {
-            *list++ = Move::NewQuiet(from, to);
-        } else {
+        if (Type == GenType::Captures || (Type != GenType::Quiets && Type != GenType::QuietChecks && pos.GetBoard(to) != Piece::None)) {
             *list++ = Move::NewCapture(from, to);
+        } else {
+            *list++ = Move::NewQuiet(from, to);
         }
     }
     return list;
 }
 
-template <Color This>
-static Move* GenerateCastlingMoves(Move* list, const Position& pos) {
+// Keeps only the moves in [begin, end) that give check, in their generation order
+static Move* KeepChecks(const Position& pos, Move* begin, Move* end) {
+    Move* out = begin;
+    for (Move* move = begin; move < end; ++move) {
+        if (pos.GivesCheck(*move)) *out++ = *move;
+    }
+    return out;
+}
+
+template <Color This, GenType Type, typename Pos>
+static Move* GenerateNormalKingMoves(Move* list, const Pos& pos, Bitboard allowedTargets) {
+    constexpr Color Other = This == Color::White ? Color::Black : Color::White;
+
+    Square from = pos.GetKingPosition(This);
+    Bitboard movesBB = BB::Attacks<PieceType::King>(from);
+    movesBB &= ~pos.GetCheckSquares(); // King may not move into check
+    movesBB &= allowedTargets;
+    if constexpr (Type == GenType::QuietChecks) {
+        // The king can only give a discovered check by leaving the line to the other king
+        if (!(pos.GetDiscoveredCheckCandidates() & BB::SquareBB(from))) return list;
+        movesBB &= ~BB::Line(from, pos.GetKingPosition(Other));
+    }
+    return AddPieceMoves<Type>(list, pos, from, movesBB);
+}
+
+template <Color This, typename Pos>
+static Move* GenerateCastlingMoves(Move* list, const Pos& pos) {
     constexpr Color Other = This == Color::White ? Color::Black : Color::White;
 
     constexpr BoardRank CastlingRank = This == Color::White ? BoardRank::R1 : BoardRank::R8;
@@ -49,9 +72,10 @@ static Move* GenerateCastlingMoves(Move* list, const Position& pos) {
     return list;
 }
 
-template <Color This, PieceType PType>
-static Move* GenerateBigPieceMoves(Move* list, const Position& pos, Bitboard allowedTargets) {
+template <Color This, PieceType PType, GenType Type, typename Pos>
+static Move* GenerateBigPieceMoves(Move* list, const Pos& pos, Bitboard allowedTargets) {
     static_assert(PType != PieceType::King && PType != PieceType::Pawn);
+    constexpr Color Other = This == Color::White ? Color::Black : Color::White;
 
     Bitboard piecesBB = pos.GetPiecesBB(This, PType);
     while (piecesBB) {
@@ -61,14 +85,14 @@ static Move* GenerateBigPieceMoves(Move* list, const Position& pos, Bitboard all
         if (pos.GetPinned(This) & BB::SquareBB(from)) {
             movesBB &= BB::Line(pos.GetKingPosition(This), from);
         }
-        while (movesBB) {
-            Square to = BB::PopLsb(movesBB);
-            if (pos.GetBoard(to) == Piece::None) {
-                *list++ = Move::NewQuiet(from, to);
-            } else {
-                *list++ = Move::NewCapture(from, to);
+        if constexpr (Type == GenType::QuietChecks) {
+            Bitboard checkingTargets = pos.GetCheckingSquares(PType);
+            if (pos.GetDiscoveredCheckCandidates() & BB::SquareBB(from)) {
+                checkingTargets |= ~BB::Line(from, pos.GetKingPosition(Other));
             }
+            movesBB &= checkingTargets;
         }
+        list = AddPieceMoves<Type>(list, pos, from, movesBB);
     }
     return list;
 }
@@ -96,8 +120,8 @@ static Move* AddPromotions(Move* list, Bitboard bb) {
     return list;
 }
 
-template <Color This>
-static bool EnPassantAllowed(const Position& pos) {
+template <Color This, typename Pos>
+static bool EnPassantAllowed(const Pos& pos) {
     constexpr Direction Forward = This == Color::White ? Direction::Up : Direction::Down;
 
     if (!pos.IsCheck()) return true;
@@ -106,8 +130,8 @@ static bool EnPassantAllowed(const Position& pos) {
     return false;
 }
 
-template <Color This>
-static Move* TryEnPassant(Move* list, const Position& pos, Square from, Square to) {
+template <Color This, typename Pos>
+static Move* TryEnPassant(Move* list, const Pos& pos, Square from, Square to) {
     constexpr Color Other = This == Color::White ? Color::Black : Color::White;
 
     Square captured = MakeSquare(FileOf(to), RankOf(from));
@@ -121,8 +145,9 @@ static Move* TryEnPassant(Move* list, const Position& pos, Square from, Square t
     return list;
 }
 
-template <Color This>
-static Move* GeneratePawnMoves(Move* list, const Position& pos, Bitboard allowedTargets) {
+// Pushes, captures and promotions (no en passant) of the given pawns
+template <Color This, GenType Type, typename Pos>
+static Move* GenerateNormalPawnMoves(Move* list, const Pos& pos, Bitboard pawns, Bitboard allowedTargets) {
     constexpr Color Other = This == Color::White ? Color::Black : Color::White;
 
     constexpr Direction Forward             = This == Color::White ? Direction::Up : Direction::Down;
@@ -132,11 +157,6 @@ static Move* GeneratePawnMoves(Move* list, const Position& pos, Bitboard allowed
     constexpr Bitboard Rank3BB              = BB::RankBB(Rank3);
     constexpr Bitboard PrePromotionRankBB   = BB::RankBB(PrePromotionRank);
     constexpr Bitboard PromotionRankBB      = BB::RankBB(PromotionRank);
-    
-    Bitboard pawns = pos.GetPiecesBB(This, PieceType::Pawn);
-    if (!pawns) return list;
-
-    Move* listStart = list;
 
     Bitboard free           = ~pos.GetOccupancy();
     Bitboard occupancyOther = pos.GetOccupancy(Other);
@@ -153,7 +173,11 @@ static Move* GeneratePawnMoves(Move* list, const Position& pos, Bitboard allowed
         Bitboard forwardPromotion       = forwardSingle & PromotionRankBB;
         Bitboard captureLeftPromotion   = captureLeft & PromotionRankBB;
         Bitboard captureRightPromotion  = captureRight & PromotionRankBB;
+        Move* promotionsStart = list;
         list = AddPromotions<Forward, Move::NewPromotionNormal>(list, forwardPromotion);
+        if constexpr (Type == GenType::QuietChecks) {
+            list = KeepChecks(pos, promotionsStart, list);
+        }
         list = AddPromotions<Forward + Direction::Left, Move::NewPromotionCapture>(list, captureLeftPromotion);
         list = AddPromotions<Forward + Direction::Right, Move::NewPromotionCapture>(list, captureRightPromotion);
         
@@ -162,41 +186,75 @@ static Move* GeneratePawnMoves(Move* list, const Position& pos, Bitboard allowed
         captureRight    &= ~PromotionRankBB;
     }
 
+    if constexpr (Type == GenType::QuietChecks) {
+        // Direct checks, or discovered checks by pawns leaving the line to the other king
+        Square otherKing = pos.GetKingPosition(Other);
+        Bitboard discoveringPawns = pos.GetDiscoveredCheckCandidates() & pawns & ~BB::FileBB(FileOf(otherKing));
+        Bitboard checkingSquares = pos.GetCheckingSquares(PieceType::Pawn);
+        forwardSingle &= checkingSquares | BB::Shift<Forward>(discoveringPawns);
+        forwardDouble &= checkingSquares | BB::Shift<Forward + Forward>(discoveringPawns);
+    }
+
     list = AddNormalPawnMoves<Forward, Move::NewQuiet>(list, forwardSingle);
     list = AddNormalPawnMoves<Forward + Forward, Move::NewDoublePawnPush>(list, forwardDouble);
     list = AddNormalPawnMoves<Forward + Direction::Left, Move::NewCapture>(list, captureLeft);
     list = AddNormalPawnMoves<Forward + Direction::Right, Move::NewCapture>(list, captureRight);
+    return list;
+}
+
+template <Color This, GenType Type, typename Pos>
+static Move* GeneratePawnMoves(Move* list, const Pos& pos, Bitboard allowedTargets) {
+    constexpr Color Other = This == Color::White ? Color::Black : Color::White;
+    
+    Bitboard pawns = pos.GetPiecesBB(This, PieceType::Pawn);
+    if (!pawns) return list;
+
+    Bitboard pinnedPawns = pos.GetPinned(This) & pawns;
+    Square kingSquare = pos.GetKingPosition(This);
+
+    list = GenerateNormalPawnMoves<This, Type>(list, pos, pawns & ~pinnedPawns, allowedTargets);
+
+    // A pinned pawn may only move along the pin line, which never resolves a check
+    if (!pos.IsCheck()) {
+        Bitboard pinnedPawnsLeft = pinnedPawns;
+        while (pinnedPawnsLeft) {
+            Square from = BB::PopLsb(pinnedPawnsLeft);
+            Bitboard pinLine = BB::Line(kingSquare, from);
+            list = GenerateNormalPawnMoves<This, Type>(list, pos, BB::SquareBB(from), allowedTargets & pinLine);
+        }
+    }
 
     Square enPassant = pos.GetEnPassant();
-    if (enPassant != Square::None && EnPassantAllowed<This>(pos)) {
+    constexpr bool GenEnPassant = Type == GenType::Captures || Type == GenType::Evasions || Type == GenType::All;
+    if (GenEnPassant && enPassant != Square::None && EnPassantAllowed<This>(pos)) {
         Bitboard enPassantingPawns = BB::PawnAttacks<Other>(enPassant) & pawns;
         while (enPassantingPawns) {
             Square from = BB::PopLsb(enPassantingPawns);
+            if ((pinnedPawns & BB::SquareBB(from)) && !BB::OnLine(kingSquare, from, enPassant)) continue;
             list = TryEnPassant<This>(list, pos, from, enPassant);
         }
     }
-
-    // Remove pawn moves that ignore a pin
-    Bitboard pinnedPawns = pos.GetPinned(This) & pawns;
-    if (pinnedPawns) {
-        Bitboard kingBB = pos.GetPiecesBB(This, PieceType::King);
-        for (Move* pawnMoves = listStart; pawnMoves < list; ++pawnMoves) {
-            Square from = pawnMoves->GetFrom();
-            if ((BB::SquareBB(from) & pinnedPawns) && !(BB::Line(from, pawnMoves->GetTo()) & kingBB)) 
-                *pawnMoves-- = *(--list);
-        }
-    }
     
     return list;
 }
 
-template <Color This>
-static Move* GenerateMoves(Move* list, const Position& pos) {
-    Bitboard ThisOccupied = pos.GetOccupancy(This);
-    Bitboard allowedTargets = ~ThisOccupied;
+template <Color This, GenType Type, typename Pos>
+static Move* GenerateMoves(Move* list, const Pos& pos) {
+    constexpr Color Other = This == Color::White ? Color::Black : Color::White;
+    assert(Type != GenType::Evasions || pos.IsCheck());
+    assert(Type != GenType::QuietChecks || !pos.IsCheck());
+
+    Bitboard allowedTargets;
+    if constexpr (Type == GenType::Captures) {
+        allowedTargets = pos.GetOccupancy(Other);
+    } else if constexpr (Type == GenType::Quiets || Type == GenType::QuietChecks) {
+        allowedTargets = ~pos.GetOccupancy();
+    } else {
+        allowedTargets = ~pos.GetOccupancy(This);
+    }
     Bitboard kingAttackers = pos.GetKingAttackers();
 
-    list = GenerateNormalKingMoves<This>(list, pos, allowedTargets);
+    list = GenerateNormalKingMoves<This, Type>(list, pos, allowedTargets);
 
     if (pos.IsDoubleCheck()) {
         // Only normal king moves
@@ -208,22 +266,58 @@ static Move* GenerateMoves(Move* list, const Position& pos) {
         Square kingSquare = pos.GetKingPosition(This);
         Square attackerSquare = BB::Lsb(kingAttackers);
         allowedTargets &= BB::Between(kingSquare, attackerSquare) | kingAttackers;
-    } else {
+    } else if constexpr (Type == GenType::QuietChecks) {
+        Move* castlingStart = list;
+        list = GenerateCastlingMoves<This>(list, pos);
+        list = KeepChecks(pos, castlingStart, list);
+    } else if constexpr (Type != GenType::Captures) {
         list = GenerateCastlingMoves<This>(list, pos);
     }
 
-    list = GenerateBigPieceMoves<This, PieceType::Queen>(list, pos, allowedTargets);
-    list = GenerateBigPieceMoves<This, PieceType::Rook>(list, pos, allowedTargets);
-    list = GenerateBigPieceMoves<This, PieceType::Bishop>(list, pos, allowedTargets);
-    list = GenerateBigPieceMoves<This, PieceType::Knight>(list, pos, allowedTargets);
-    list = GeneratePawnMoves<This>(list, pos, allowedTargets);
+    list = GenerateBigPieceMoves<This, PieceType::Queen, Type>(list, pos, allowedTargets);
+    list = GenerateBigPieceMoves<This, PieceType::Rook, Type>(list, pos, allowedTargets);
+    list = GenerateBigPieceMoves<This, PieceType::Bishop, Type>(list, pos, allowedTargets);
+    list = GenerateBigPieceMoves<This, PieceType::Knight, Type>(list, pos, allowedTargets);
+    list = GeneratePawnMoves<This, Type>(list, pos, allowedTargets);
     return list;
 }
 
-Move* GenerateMoves(Move* list, const Position& pos) {
+template <GenType Type, typename Pos>
+static Move* GenerateMovesForSideToMove(Move* list, const Pos& pos) {
+    PROFILE_SCOPE(GenerateMoves);
     if (pos.GetSideToMove() == Color::White) {
-        return GenerateMoves<Color::White>(list, pos);
+        return GenerateMoves<Color::White, Type>(list, pos);
     } else {
-        return GenerateMoves<Color::Black>(list, pos);
+        return GenerateMoves<Color::Black, Type>(list, pos);
     }
-}
\ No newline at end of file
+}
+
+template <GenType Type>
+Move* GenerateMoves(Move* list, const Position& pos) {
+    return GenerateMovesForSideToMove<Type>(list, pos);
+}
+
+template <GenType Type>
+Move* GenerateMoves(Move* list, const CompactPosition& pos) {
+    static_assert(Type != GenType::QuietChecks, "CompactPosition keeps no check info");
+    return GenerateMovesForSideToMove<Type>(list, pos);
+}
+
+template Move* GenerateMoves<GenType::Captures>(Move* list, const Position& pos);
+template Move* GenerateMoves<GenType::Quiets>(Move* list, const Position& pos);
+template Move* GenerateMoves<GenType::Evasions>(Move* list, const Position& pos);
+template Move* GenerateMoves<GenType::QuietChecks>(Move* list, const Position& pos);
+template Move* GenerateMoves<GenType::All>(Move* list, const Position& pos);
+
+template Move* GenerateMoves<GenType::Captures>(Move* list, const CompactPosition& pos);
+template Move* GenerateMoves<GenType::Quiets>(Move* list, const CompactPosition& pos);
+template Move* GenerateMoves<GenType::Evasions>(Move* list, const CompactPosition& pos);
+template Move* GenerateMoves<GenType::All>(Move* list, const CompactPosition& pos);
+
+Move* GenerateMoves(Move* list, const Position& pos) {
+    return GenerateMovesForSideToMove<GenType::All>(list, pos);
+}
+
+Move* GenerateMoves(Move* list, const CompactPosition& pos) {
+    return GenerateMovesForSideToMove<GenType::All>(list, pos);
+}
@@ -1,5 +1,27 @@
 #pragma once
 
 #include "position.hpp"
+#include "compact_position.hpp"
+
+// Upper bound for the number of legal moves in any position
+constexpr int MAX_MOVES = 256;
+
+/**
+ * Selects which legal moves are generated
+ * Captures:    captures including en passant and capture promotions
+ * Quiets:      all other moves including castling and non-capture promotions
+ * Evasions:    all moves, only valid while in check
+ * QuietChecks: quiet moves giving check, only valid while not in check (Position only)
+ * All:         all moves
+ */
+enum class GenType : uint8_t {
+    Captures, Quiets, Evasions, QuietChecks, All
+};
+
+template <GenType Type>
+Move* GenerateMoves(Move* list, const Position& pos);
+template <GenType Type>
+Move* GenerateMoves(Move* list, const CompactPosition& pos);
 
 Move* GenerateMoves(Move* list, const Position& pos);
+Move* GenerateMoves(Move* list, const CompactPosition& pos);
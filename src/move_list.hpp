@@ -4,18 +4,19 @@
 #include "move.hpp"
 #include "move_generation.hpp"
 
+template <GenType Type = GenType::All>
 class MoveList {
 public:
-    MoveList(const Position& pos) { mEnd = GenerateMoves(mMoves.begin(), pos); }
+    template <typename Pos>
+    MoveList(const Pos& pos) { mEnd = GenerateMoves<Type>(mMoves.begin(), pos); }
 
     Move* begin()               { return mMoves.begin(); }
     Move* end()                 { return mEnd; }
     const Move* begin() const   { return mMoves.begin(); }
     const Move* end() const     { return mEnd; }
+    size_t size() const         { return mEnd - mMoves.begin(); }
 
 private:
-    static constexpr int MAX_NUM_MOVES = 256;
-
-    Array<Move, MAX_NUM_MOVES> mMoves;
+    Array<Move, MAX_MOVES> mMoves;
     Move* mEnd;
-};
\ No newline at end of file
+};
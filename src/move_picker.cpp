@@ -0,0 +1,97 @@
+#include "move_picker.hpp"
+
+#include <utility>
+
+// Most valuable victim first, least valuable attacker as tie break
+static constexpr Array<int16_t, PIECE_TYPE_NUM> VictimValues   = { 30, 30, 50, 90, 0, 10 };
+static constexpr Array<int16_t, PIECE_TYPE_NUM> AttackerValues = {  3,  3,  5,  9, 10, 1 };
+
+MovePicker::MovePicker(const Position& pos, Move hashMove)
+    : mPos(pos), mHashMove(hashMove), mSkipQuiets(false), mCurrent(mMoves.begin()), mEnd(mMoves.begin()) {
+    if (mHashMove == Move::NewNone() || !pos.IsPseudoLegal(mHashMove) || !pos.IsLegal(mHashMove)) {
+        mHashMove = Move::NewNone();
+        mStage = pos.IsCheck() ? Stage::GenerateEvasions : Stage::GenerateCaptures;
+    } else {
+        mStage = Stage::HashMove;
+    }
+}
+
+MovePicker::MovePicker(const Position& pos)
+    : mPos(pos), mHashMove(Move::NewNone()), mSkipQuiets(true), mCurrent(mMoves.begin()), mEnd(mMoves.begin()) {
+    mStage = pos.IsCheck() ? Stage::GenerateEvasions : Stage::GenerateCaptures;
+}
+
+Move MovePicker::Next() {
+    while (true) {
+        switch (mStage) {
+        case Stage::HashMove:
+            mStage = mPos.IsCheck() ? Stage::GenerateEvasions : Stage::GenerateCaptures;
+            return mHashMove;
+
+        case Stage::GenerateCaptures:
+            mCurrent = mMoves.begin();
+            mEnd = GenerateMoves<GenType::Captures>(mCurrent, mPos);
+            ScoreCaptures();
+            mStage = Stage::Captures;
+            break;
+
+        case Stage::Captures:
+            while (mCurrent < mEnd) {
+                Move move = PopBestCapture();
+                if (move != mHashMove) return move;
+            }
+            mStage = mSkipQuiets ? Stage::Done : Stage::GenerateQuiets;
+            break;
+
+        case Stage::GenerateQuiets:
+            mCurrent = mMoves.begin();
+            mEnd = GenerateMoves<GenType::Quiets>(mCurrent, mPos);
+            mStage = Stage::Quiets;
+            break;
+
+        case Stage::Quiets:
+            while (mCurrent < mEnd) {
+                Move move = *mCurrent++;
+                if (move != mHashMove) return move;
+            }
+            mStage = Stage::Done;
+            break;
+
+        case Stage::GenerateEvasions:
+            mCurrent = mMoves.begin();
+            mEnd = GenerateMoves<GenType::Evasions>(mCurrent, mPos);
+            mStage = Stage::Evasions;
+            break;
+
+        case Stage::Evasions:
+            while (mCurrent < mEnd) {
+                Move move = *mCurrent++;
+                if (move != mHashMove) return move;
+            }
+            mStage = Stage::Done;
+            break;
+
+        case Stage::Done:
+            return Move::NewNone();
+        }
+    }
+}
+
+void MovePicker::ScoreCaptures() {
+    for (Move* move = mCurrent; move < mEnd; ++move) {
+        PieceType victim = move->IsEnPassant() ? PieceType::Pawn : PieceTypeOf(mPos.GetBoard(move->GetTo()));
+        PieceType attacker = PieceTypeOf(mPos.GetBoard(move->GetFrom()));
+        mScores[move - mMoves.begin()] = VictimValues[ToInt(victim)] - AttackerValues[ToInt(attacker)];
+    }
+}
+
+// Selection sort step: cutoffs usually happen before the list is exhausted
+Move MovePicker::PopBestCapture() {
+    Move* best = mCurrent;
+    for (Move* move = mCurrent + 1; move < mEnd; ++move) {
+        if (mScores[move - mMoves.begin()] > mScores[best - mMoves.begin()]) best = move;
+    }
+    std::swap(*best, *mCurrent);
+    std::swap(mScores[best - mMoves.begin()], mScores[mCurrent - mMoves.begin()]);
+    return *mCurrent++;
+}
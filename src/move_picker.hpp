@@ -0,0 +1,42 @@
+#pragma once
+
+#include "position.hpp"
+#include "move.hpp"
+#include "move_generation.hpp"
+
+/**
+ * Hands out the moves of a position stage by stage: hash move, captures (MVV-LVA ordered), quiets
+ * Each stage is only generated once it is reached, so a cutoff in an early stage saves the rest
+ * While in check all evasions are generated at once
+ */
+class MovePicker {
+public:
+    // Main search: hash move, captures and quiets
+    MovePicker(const Position& pos, Move hashMove);
+    // Quiescence search: captures only, or all evasions while in check
+    explicit MovePicker(const Position& pos);
+
+    // Returns Move::NewNone() once all moves have been handed out
+    Move Next();
+
+private:
+    enum class Stage : uint8_t {
+        HashMove,
+        GenerateCaptures, Captures,
+        GenerateQuiets, Quiets,
+        GenerateEvasions, Evasions,
+        Done
+    };
+
+    const Position& mPos;
+    Move mHashMove;
+    Stage mStage;
+    bool mSkipQuiets;
+    Array<Move, MAX_MOVES> mMoves;
+    Array<int16_t, MAX_MOVES> mScores;
+    Move* mCurrent;
+    Move* mEnd;
+
+    void ScoreCaptures();
+    Move PopBestCapture();
+};
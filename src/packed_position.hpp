@@ -0,0 +1,53 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <bit>
+#include <type_traits>
+
+/**
+ * Fixed-size binary encoding of a position
+ * The pieces are stored as 4-bit piece codes in the order of the set bits of the occupancy
+ * (least significant bit first, low nibble first), followed by the remaining game state.
+ * Files of PackedPosition records are read in place, so the layout is the on-disk format.
+ */
+struct PackedPosition {
+    static constexpr uint8_t MAX_PIECES = 32;
+
+    uint64_t occupancy;
+    Array<uint8_t, MAX_PIECES / 2> pieces;
+    uint8_t sideToMove;
+    uint8_t castlingRights;
+    uint8_t enPassant;              // ToInt(Square::None) without en passant square
+    uint8_t reversableHalfMoves;    // Saturates at 255
+    uint16_t moveNum;
+    uint16_t reserved;
+
+    uint8_t GetPiece(uint8_t index) const {
+        return (pieces[index >> 1] >> ((index & 1) * 4)) & 0xF;
+    }
+
+    void SetPiece(uint8_t index, uint8_t piece) {
+        pieces[index >> 1] |= piece << ((index & 1) * 4);
+    }
+};
+
+/**
+ * A position labeled for evaluation training (see datagen)
+ * Score and result are from the point of view of the side to move
+ */
+struct TrainingRecord {
+    PackedPosition position;
+    int16_t score;                  // Search score in centipawns
+    uint16_t bestMove;              // Move::GetRaw()
+    int8_t result;                  // 1 win, 0 draw, -1 loss
+    Array<uint8_t, 3> reserved;
+};
+
+// The file format is little endian
+static_assert(std::endian::native == std::endian::little);
+static_assert(sizeof(PackedPosition) == 32);
+static_assert(std::is_trivially_copyable_v<PackedPosition>);
+static_assert(sizeof(TrainingRecord) == 40);
+static_assert(std::is_trivially_copyable_v<TrainingRecord>);
@@ -0,0 +1,47 @@
+#include "packed_position_file.hpp"
+
+#include <stdexcept>
+
+template <typename Record>
+RecordReader<Record>::RecordReader(const std::string& path) : mFile(path) {
+    if (mFile.GetSize() % sizeof(Record) != 0)
+        throw std::runtime_error("Truncated record file: " + path);
+    mBegin  = reinterpret_cast<const Record*>(mFile.GetData());
+    mSize   = mFile.GetSize() / sizeof(Record);
+}
+
+template <typename Record>
+RecordWriter<Record>::RecordWriter(const std::string& path) {
+    mFile = std::fopen(path.c_str(), "ab");
+    if (!mFile) throw std::runtime_error("Cannot open file: " + path);
+    mBuffer.reserve(BUFFER_RECORDS);
+}
+
+template <typename Record>
+RecordWriter<Record>::~RecordWriter() {
+    WriteBuffer();
+    std::fclose(mFile);
+}
+
+template <typename Record>
+void RecordWriter<Record>::Write(const Record* records, std::size_t count) {
+    Flush();
+    if (std::fwrite(records, sizeof(Record), count, mFile) != count) throw std::runtime_error("Cannot write records");
+}
+
+template <typename Record>
+void RecordWriter<Record>::Flush() {
+    if (!WriteBuffer()) throw std::runtime_error("Cannot write records");
+}
+
+template <typename Record>
+bool RecordWriter<Record>::WriteBuffer() {
+    bool written = std::fwrite(mBuffer.data(), sizeof(Record), mBuffer.size(), mFile) == mBuffer.size();
+    mBuffer.clear();
+    return written;
+}
+
+template class RecordReader<PackedPosition>;
+template class RecordWriter<PackedPosition>;
+template class RecordReader<TrainingRecord>;
+template class RecordWriter<TrainingRecord>;
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "packed_position.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Iterates a file of fixed-size records in place, without copying or allocating per record
+ * Instantiated for PackedPosition and TrainingRecord
+ */
+template <typename Record>
+class RecordReader {
+public:
+    explicit RecordReader(const std::string& path);
+
+    const Record* begin() const                     { return mBegin; }
+    const Record* end() const                       { return mBegin + mSize; }
+    std::size_t size() const                        { return mSize; }
+    const Record& operator[](std::size_t i) const   { return mBegin[i]; }
+
+private:
+    MappedFile mFile;
+    const Record* mBegin;
+    std::size_t mSize;
+};
+
+/**
+ * Appends fixed-size records to a file through a fixed-size buffer
+ */
+template <typename Record>
+class RecordWriter {
+public:
+    explicit RecordWriter(const std::string& path);
+    ~RecordWriter();
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    void Write(const Record& record);
+    // Writes the buffer and then the records directly
+    void Write(const Record* records, std::size_t count);
+    void Flush();
+
+private:
+    static constexpr std::size_t BUFFER_RECORDS = 4096;
+
+    std::FILE* mFile;
+    std::vector<Record> mBuffer;
+
+    bool WriteBuffer();
+};
+
+using PackedPositionReader = RecordReader<PackedPosition>;
+using PackedPositionWriter = RecordWriter<PackedPosition>;
+using TrainingRecordReader = RecordReader<TrainingRecord>;
+using TrainingRecordWriter = RecordWriter<TrainingRecord>;
+
+template <typename Record>
+inline void RecordWriter<Record>::Write(const Record& record) {
+    mBuffer.push_back(record);
+    if (mBuffer.size() == BUFFER_RECORDS) Flush();
+}
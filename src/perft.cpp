@@ -1,58 +1,41 @@
-#include "position.hpp"
+#include "perft.hpp"
 #include "move_list.hpp"
-#include "move_generation.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
-#include <format>
-
-struct PerftResult {
-    uint64_t moves = 0;
-    uint64_t captures = 0;
-    uint64_t enPassant = 0;
-    uint64_t castles = 0;
-    uint64_t promotions = 0;
-    uint64_t checks = 0;
-    uint64_t doubleChecks = 0;
-
-    bool operator==(const PerftResult& other) const {
-        return
-            moves           == other.moves      &&
-            captures        == other.captures   &&
-            enPassant       == other.enPassant  &&
-            castles         == other.castles    && 
-            promotions      == other.promotions &&
-            checks          == other.checks     &&
-            doubleChecks    == other.doubleChecks;
-    }
-    bool operator!=(const PerftResult& other) const {
-        return !(*this == other);
-    }
-};
+#include <memory>
+#include <thread>
+#include <vector>
 
 std::ostream& operator<<(std::ostream& stream, const PerftResult& result) {
-    return stream << std::format(
-        "[moves={}, captures={}, enPassant={}, castles={}, "
-        "promotions={}, checks={}, doubleChecks={}]",
-        result.moves, result.captures, result.enPassant, result.castles, 
-        result.promotions, result.checks, result.doubleChecks
-    );
+    return stream 
+        << "[moves=" << result.moves << ", captures=" << result.captures 
+        << ", enPassant=" << result.enPassant << ", castles=" << result.castles 
+        << ", promotions=" << result.promotions << ", checks=" << result.checks 
+        << ", doubleChecks=" << result.doubleChecks << "]";
 }
 
-uint64_t PerftSimple(Position& pos, int depth) {
+template <bool BulkCounting>
+static uint64_t PerftSimple(Position& pos, int depth) {
     if (depth == 0) return 1;
 
     MoveList moveList(pos);
-    if (depth == 1) return moveList.end() - moveList.begin();
+    if (BulkCounting && depth == 1) return moveList.size();
 
     uint64_t numMoves = 0;
     for (Move move : moveList) {
         pos.DoMove(move);
-        numMoves += PerftSimple(pos, depth - 1);
+        numMoves += PerftSimple<BulkCounting>(pos, depth - 1);
         pos.UndoMove();
     }
     return numMoves;
 }
 
+uint64_t PerftSimple(Position& pos, int depth, bool bulkCounting) {
+    return bulkCounting ? PerftSimple<true>(pos, depth) : PerftSimple<false>(pos, depth);
+}
+
 void Perft(Position& pos, int depth, PerftResult& result) {
     MoveList moveList(pos);
 
@@ -83,76 +66,153 @@ PerftResult Perft(Position& pos, int depth) {
     return result;
 }
 
-void TestPerftSimple(const char* fen, int depth, uint64_t correctNumMoves) {
-    Position pos(fen);
-    uint64_t numMoves = PerftSimple(pos, depth);
-    if (numMoves == correctNumMoves) {
-        std::cout   << "PASSED:\tSimple Perft [" << fen << ", depth=" << depth << "]" << std::endl;
-    } else {
-        std::cout   << "FAILED:\tSimple Perft [" << fen << ", depth=" << depth << "]: " 
-                    << "expected=" << correctNumMoves << " result=" << numMoves << std::endl;
+uint64_t PerftHashed(Position& pos, int depth, PerftTable& table, PerftHashStats& stats) {
+    if (depth == 0) return 1;
+
+    if (depth == 1) return MoveList(pos).size();   // Cheaper than a probe
+
+    uint64_t numMoves;
+    ++stats.probes;
+    if (table.Probe(pos.GetZobristHash(), depth, numMoves)) {
+        ++stats.hits;
+        return numMoves;
+    }
+
+    // Generated only on a miss: a hit needs no moves
+    numMoves = 0;
+    for (Move move : MoveList(pos)) {
+        pos.DoMove(move);
+        numMoves += PerftHashed(pos, depth - 1, table, stats);
+        pos.UndoMove();
     }
+    table.Store(pos.GetZobristHash(), depth, numMoves);
+    return numMoves;
 }
 
-void TestPerft(const char* fen, int depth, const PerftResult& correctPerftResult) {
-    Position pos(fen);
-    PerftResult result = Perft(pos, depth);
-    if (result == correctPerftResult) {
-        std::cout   << "PASSED:\tPerft [" << fen << ", depth=" << depth << "]" << std::endl;
-    } else {
-        std::cout   << "FAILED:\tPerft [" << fen << ", depth=" << depth << "]: " << std::endl;
-        std::cout   << "expected=" << correctPerftResult << std::endl;
-        std::cout   << "result=" << result << std::endl;
+namespace {
+    // Moves from the root to the root of the job's subtree
+    struct PerftJob {
+        static constexpr int MAX_SPLIT_PLY = 4;
+
+        Array<Move, MAX_SPLIT_PLY> moves;
+        int numMoves = 0;
+    };
+
+    // Contiguous range of the job list, owned by one worker but open for stealing
+    struct alignas(64) JobSlice {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    template <typename Result>
+    struct alignas(64) WorkerResult {
+        Result result = {};
+    };
+}
+
+// Splits at the first ply that gives every thread enough jobs to balance the load,
+// leaving at least one ply to each job
+static std::vector<PerftJob> SplitPerft(Position& pos, int depth, int threads) {
+    constexpr size_t JobsPerThread = 32;
+    const int maxSplitPly = std::min(depth - 1, PerftJob::MAX_SPLIT_PLY);
+
+    std::vector<PerftJob> jobs(1);
+    for (int ply = 0; ply < maxSplitPly && jobs.size() < JobsPerThread * threads; ++ply) {
+        std::vector<PerftJob> nextJobs;
+        for (const PerftJob& job : jobs) {
+            for (int i = 0; i < job.numMoves; ++i) pos.DoMove(job.moves[i]);
+            for (Move move : MoveList(pos)) {
+                PerftJob& nextJob = nextJobs.emplace_back(job);
+                nextJob.moves[nextJob.numMoves++] = move;
+            }
+            for (int i = 0; i < job.numMoves; ++i) pos.UndoMove();
+        }
+        jobs = std::move(nextJobs);
     }
+    return jobs;
+}
+
+template <typename Result, typename CountSubtree>
+static Result RunParallel(const Position& root, int depth, int threads, CountSubtree countSubtree) {
+    threads = std::max(threads, 1);
+    auto scratch = std::make_unique<Position>(root);
+    std::vector<PerftJob> jobs = SplitPerft(*scratch, depth, threads);
+
+    std::vector<JobSlice> slices(threads);
+    for (int i = 0; i < threads; ++i) {
+        slices[i].next = jobs.size() * i / threads;
+        slices[i].end = jobs.size() * (i + 1) / threads;
+    }
+    std::vector<WorkerResult<Result>> results(threads);
+
+    auto work = [&](int worker) {
+        auto pos = std::make_unique<Position>(root);
+        Result result = {};
+        for (int i = 0; i < threads; ++i) {
+            JobSlice& slice = slices[(worker + i) % threads];
+            for (size_t index = slice.next++; index < slice.end; index = slice.next++) {
+                const PerftJob& job = jobs[index];
+                for (int ply = 0; ply < job.numMoves; ++ply) pos->DoMove(job.moves[ply]);
+                countSubtree(*pos, depth - job.numMoves, result);
+                for (int ply = 0; ply < job.numMoves; ++ply) pos->UndoMove();
+            }
+        }
+        results[worker].result = result;
+    };
+
+    std::vector<std::thread> workers;
+    for (int worker = 1; worker < threads; ++worker) workers.emplace_back(work, worker);
+    work(0);
+    for (std::thread& worker : workers) worker.join();
+
+    Result total = {};
+    for (const WorkerResult<Result>& result : results) total += result.result;
+    return total;
+}
+
+uint64_t PerftSimpleParallel(const Position& pos, int depth, int threads, bool bulkCounting) {
+    return RunParallel<uint64_t>(pos, depth, threads, [bulkCounting](Position& pos, int depth, uint64_t& result) {
+        result += PerftSimple(pos, depth, bulkCounting);
+    });
+}
+
+PerftResult PerftParallel(const Position& pos, int depth, int threads) {
+    return RunParallel<PerftResult>(pos, depth, threads, [](Position& pos, int depth, PerftResult& result) {
+        Perft(pos, depth, result);
+    });
+}
+
+namespace {
+    struct HashedResult {
+        uint64_t nodes = 0;
+        PerftHashStats stats;
+
+        HashedResult& operator+=(const HashedResult& other) {
+            nodes += other.nodes;
+            stats += other.stats;
+            return *this;
+        }
+    };
+}
+
+uint64_t PerftHashedParallel(const Position& pos, int depth, int threads, PerftTable& table, PerftHashStats& stats) {
+    HashedResult result = RunParallel<HashedResult>(pos, depth, threads, [&table](Position& pos, int depth, HashedResult& result) {
+        result.nodes += PerftHashed(pos, depth, table, result.stats);
+    });
+    stats += result.stats;
+    return result.nodes;
 }
 
-void PrintPerftPerMove(Position& pos, int depth) {
+uint64_t PrintPerftPerMove(Position& pos, int depth, bool bulkCounting) {
     MoveList list(pos);
     uint64_t total = 0;
     for (Move move : list) {
         pos.DoMove(move);
-        uint64_t perftResult = PerftSimple(pos, depth - 1);
-        total += perftResult;
-        Square from = move.GetFrom();
-        Square to = move.GetTo();
-        std::cout 
-            << char('a' + ToInt(FileOf(from))) << char('1' + ToInt(RankOf(from)))
-            << char('a' + ToInt(FileOf(to))) << char('1' + ToInt(RankOf(to)))
-            << ": " << perftResult
-            << std::endl;
+        uint64_t perftResult = PerftSimple(pos, depth - 1, bulkCounting);
         pos.UndoMove();
+        total += perftResult;
+        std::cout << move.ToUCI() << ": " << perftResult << '\n';
     }
     std::cout << "Total: " << total << std::endl;
+    return total;
 }
-
-int main() {
-    BB::Init();
-    ZobristHash::Init();
-
-    TestPerftSimple("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 7, 3195901860);
-    TestPerft("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, {
-        119060324,
-        2812008,
-        5248,
-        0,
-        0,
-        809099,
-        46	
-    });
-
-    TestPerftSimple("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 6, 8031647685);
-    TestPerft("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, {
-        193690690,
-        35043416,
-        73365,
-        4993637,
-        8392,
-        3309887,
-        2645	
-    });
-
-    TestPerftSimple("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 8, 3009794393);
-    TestPerftSimple("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 6, 706045033);
-    TestPerftSimple("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194);
-    TestPerftSimple("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 6, 6923051137);
-}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "position.hpp"
+#include "perft_table.hpp"
+
+#include <cstdint>
+#include <ostream>
+
+// See https://www.chessprogramming.org/Perft
+struct PerftResult {
+    uint64_t moves = 0;
+    uint64_t captures = 0;
+    uint64_t enPassant = 0;
+    uint64_t castles = 0;
+    uint64_t promotions = 0;
+    uint64_t checks = 0;
+    uint64_t doubleChecks = 0;
+
+    bool operator==(const PerftResult& other) const = default;
+
+    PerftResult& operator+=(const PerftResult& other) {
+        moves           += other.moves;
+        captures        += other.captures;
+        enPassant       += other.enPassant;
+        castles         += other.castles;
+        promotions      += other.promotions;
+        checks          += other.checks;
+        doubleChecks    += other.doubleChecks;
+        return *this;
+    }
+};
+
+std::ostream& operator<<(std::ostream& stream, const PerftResult& result);
+
+// Number of leaf nodes at the given depth
+// With bulk counting the moves at depth 1 are counted without being made
+uint64_t PerftSimple(Position& pos, int depth, bool bulkCounting = true);
+
+// Counters of the moves leading to the leaf nodes, depth >= 1
+void Perft(Position& pos, int depth, PerftResult& result);
+PerftResult Perft(Position& pos, int depth);
+
+// Multi-threaded versions: the tree is split a few plies below the root into jobs, which the
+// workers take from their own slice of the job list first and then steal from the others
+uint64_t PerftSimpleParallel(const Position& pos, int depth, int threads, bool bulkCounting = true);
+PerftResult PerftParallel(const Position& pos, int depth, int threads);
+
+struct PerftHashStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+    PerftHashStats& operator+=(const PerftHashStats& other) {
+        probes  += other.probes;
+        hits    += other.hits;
+        return *this;
+    }
+};
+
+// Leaf node count like PerftSimple (with bulk counting), reusing the counts of transposed subtrees
+uint64_t PerftHashed(Position& pos, int depth, PerftTable& table, PerftHashStats& stats);
+uint64_t PerftHashedParallel(const Position& pos, int depth, int threads, PerftTable& table, PerftHashStats& stats);
+
+// Prints the number of leaf nodes below each legal move ("divide") and returns the total
+uint64_t PrintPerftPerMove(Position& pos, int depth, bool bulkCounting = true);
@@ -0,0 +1,156 @@
+#include "perft.hpp"
+#include "profile.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+using Clock = std::chrono::steady_clock;
+
+static void PrintUsage(const char* program) {
+    std::cerr 
+        << "usage: " << program << " [options] [depth]\n"
+        << "  --fen <fen>    position to count (default: start position)\n"
+        << "  --depth <n>    depth (default: 5)\n"
+        << "  --divide       print the node count below each legal move\n"
+        << "  --no-bulk      make every move at depth 1 instead of only counting them\n"
+        << "  --detailed     count captures, en passant, castles, promotions and checks\n"
+        << "  --threads <n>  worker threads (default: 1, divide is always single-threaded)\n"
+        << "  --hash <mb>    cache the node counts of transposed subtrees in a table of this size\n"
+        << "  --suite        check the reference positions against their known results\n";
+}
+
+static bool TestPerftSimple(const char* fen, int depth, uint64_t correctNumMoves, int threads) {
+    Position pos(fen);
+    uint64_t numMoves = PerftSimpleParallel(pos, depth, threads);
+    if (numMoves == correctNumMoves) {
+        std::cout   << "PASSED:\tSimple Perft [" << fen << ", depth=" << depth << "]" << std::endl;
+        return true;
+    } else {
+        std::cout   << "FAILED:\tSimple Perft [" << fen << ", depth=" << depth << "]: " 
+                    << "expected=" << correctNumMoves << " result=" << numMoves << std::endl;
+        return false;
+    }
+}
+
+static bool TestPerft(const char* fen, int depth, const PerftResult& correctPerftResult, int threads) {
+    Position pos(fen);
+    PerftResult result = PerftParallel(pos, depth, threads);
+    if (result == correctPerftResult) {
+        std::cout   << "PASSED:\tPerft [" << fen << ", depth=" << depth << "]" << std::endl;
+        return true;
+    } else {
+        std::cout   << "FAILED:\tPerft [" << fen << ", depth=" << depth << "]: " << std::endl;
+        std::cout   << "expected=" << correctPerftResult << std::endl;
+        std::cout   << "result=" << result << std::endl;
+        return false;
+    }
+}
+
+static bool RunSuite(int threads) {
+    bool passed = true;
+    passed &= TestPerftSimple("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 7, 3195901860, threads);
+    passed &= TestPerft("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, {
+        119060324,
+        2812008,
+        5248,
+        0,
+        0,
+        809099,
+        46	
+    }, threads);
+
+    passed &= TestPerftSimple("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 6, 8031647685, threads);
+    passed &= TestPerft("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, {
+        193690690,
+        35043416,
+        73365,
+        4993637,
+        8392,
+        3309887,
+        2645	
+    }, threads);
+
+    passed &= TestPerftSimple("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 8, 3009794393, threads);
+    passed &= TestPerftSimple("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 6, 706045033, threads);
+    passed &= TestPerftSimple("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194, threads);
+    passed &= TestPerftSimple("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 6, 6923051137, threads);
+    return passed;
+}
+
+int main(int argc, char** argv) {
+    std::string fen = START_FEN;
+    int depth = 5;
+    bool divide = false;
+    bool bulkCounting = true;
+    bool detailed = false;
+    bool suite = false;
+    int threads = 1;
+    size_t hashMegabytes = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--fen") == 0 && i + 1 < argc)             fen = argv[++i];
+        else if (std::strcmp(arg, "--depth") == 0 && i + 1 < argc)      depth = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--threads") == 0 && i + 1 < argc)    threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--hash") == 0 && i + 1 < argc)       hashMegabytes = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--divide") == 0)                     divide = true;
+        else if (std::strcmp(arg, "--no-bulk") == 0)                    bulkCounting = false;
+        else if (std::strcmp(arg, "--detailed") == 0)                   detailed = true;
+        else if (std::strcmp(arg, "--suite") == 0)                      suite = true;
+        else if (arg[0] != '-')                                         depth = std::atoi(arg);
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    bool hashed = hashMegabytes > 0;
+    if (depth < 1 || threads < 1 || (divide && detailed) || (hashed && (divide || detailed || !bulkCounting))) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (suite) {
+        return RunSuite(threads) ? 0 : 1;
+    }
+
+    Position pos;
+    std::string_view fenView = fen;
+    FenStatus status = pos.ParseFEN(fenView);
+    if (status != FenStatus::Ok) {
+        std::cerr << "Illegal fen: " << ToString(status) << std::endl;
+        return 1;
+    }
+
+    auto start = Clock::now();
+    uint64_t nodes;
+    if (divide) {
+        nodes = PrintPerftPerMove(pos, depth, bulkCounting);
+    } else if (detailed) {
+        PerftResult result = PerftParallel(pos, depth, threads);
+        nodes = result.moves;
+        std::cout << result << '\n';
+    } else if (hashed) {
+        PerftTable table(hashMegabytes);
+        PerftHashStats stats;
+        nodes = PerftHashedParallel(pos, depth, threads, table, stats);
+        std::cout << "Hash:  " << stats.hits << " hits / " << stats.probes << " probes ("
+                  << std::fixed << std::setprecision(1) << (stats.probes ? 100.0 * stats.hits / stats.probes : 0.0)
+                  << "%)\n";
+    } else {
+        nodes = PerftSimpleParallel(pos, depth, threads, bulkCounting);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Nodes: " << nodes << '\n'
+              << "Time:  " << seconds << " s\n"
+              << "NPS:   " << std::setprecision(0) << nodes / seconds << std::endl;
+    Profile::Dump(std::cout);
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "perft.hpp"
+#include "epd.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Runs perft over the positions of a baseline EPD file, checks the node counts and compares the
+// speed against the recorded nps. Exits with 1 on a wrong count or when the geometric mean of the
+// speed changes is a slowdown beyond the tolerance. The recorded nps are absolute, so the baseline
+// has to be recorded with --update on the machine and build that runs the comparison.
+
+#ifndef PERFT_BASELINE_PATH
+#define PERFT_BASELINE_PATH "bench/perft_baseline.epd"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct Entry {
+    std::string fen;
+    std::string id;
+    int depth;
+    uint64_t expectedNodes;
+    uint64_t baselineNps;
+    uint64_t nodes = 0;
+    uint64_t nps = 0;
+};
+
+struct Options {
+    const char* baselinePath = PERFT_BASELINE_PATH;
+    double tolerance = 0.10;
+    double minSeconds = 1.0;
+    bool update = false;
+};
+
+static std::vector<Entry> ReadBaseline(const char* path) {
+    std::vector<Entry> entries;
+    EpdFileReader reader(path);
+    Position pos;
+    EpdRecord record;
+    FenStatus status;
+    while (reader.Next(pos, record, status)) {
+        std::string location = std::string(path) + ":" + std::to_string(reader.GetLineNumber());
+        if (status != FenStatus::Ok) throw std::runtime_error(location + ": " + ToString(status));
+        if (record.perftDepth == 0) throw std::runtime_error(location + ": missing D<depth> <nodes> operation");
+        entries.push_back({ pos.GetFEN(), std::string(record.id), record.perftDepth, record.perftNodes, record.nps });
+    }
+    return entries;
+}
+
+static void WriteBaseline(const char* path, const std::vector<Entry>& entries) {
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error(std::string("cannot write ") + path);
+    file << "# Perft regression baseline, read by perft_regression\n"
+         << "# D<depth> is the exact leaf count, nps the single-threaded speed with bulk counting\n"
+         << "# on the machine and build that last ran perft_regression --update; the nps are absolute,\n"
+         << "# so the baseline is only comparable on that machine\n";
+    for (const Entry& entry : entries) {
+        file << entry.fen << " id \"" << entry.id << "\"; D" << entry.depth << ' ' << entry.expectedNodes << "; "
+             << "nps " << entry.nps << ";\n";
+    }
+}
+
+// Repeats the perft until minSeconds have passed and keeps the fastest run, which is the least
+// disturbed by the rest of the system
+static void Measure(Entry& entry, double minSeconds) {
+    Position pos(entry.fen);
+    double totalSeconds = 0;
+    double bestSeconds = 0;
+    do {
+        auto start = Clock::now();
+        entry.nodes = PerftSimple(pos, entry.depth);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        totalSeconds += seconds;
+        if (bestSeconds == 0 || seconds < bestSeconds) bestSeconds = seconds;
+        if (entry.nodes != entry.expectedNodes) return;
+    } while (totalSeconds < minSeconds);
+    entry.nps = std::max(entry.nps, uint64_t(entry.nodes / std::max(bestSeconds, 1e-9)));
+}
+
+static bool IsSlower(const Entry& entry, double tolerance) {
+    return entry.baselineNps > 0 && entry.nps < entry.baselineNps * (1 - tolerance);
+}
+
+// Measures and reports all entries, counts the wrong node counts and returns the geometric mean of the
+// speed changes against the baseline
+static double MeasureAll(std::vector<Entry>& entries, const Options& options, int& wrongCounts) {
+    double logChangeSum = 0;
+    int compared = 0;
+    for (Entry& entry : entries) {
+        Measure(entry, options.minSeconds);
+        // A slowdown has to reproduce, a single slow measurement is usually noise from the rest of the system.
+        // It is only reported: a single position varies by more than the tolerance from run to run.
+        if (IsSlower(entry, options.tolerance) && !options.update) Measure(entry, options.minSeconds);
+
+        std::cout << std::left << std::setw(20) << entry.id << std::right << " D" << entry.depth;
+        if (entry.nodes != entry.expectedNodes) {
+            std::cout << "  FAILED: expected=" << entry.expectedNodes << " result=" << entry.nodes << std::endl;
+            ++wrongCounts;
+            continue;
+        }
+
+        std::cout << std::setw(12) << entry.nodes << " nodes " << std::setw(8) << entry.nps / 1e6 << " Mnps";
+        if (entry.baselineNps > 0) {
+            double change = double(entry.nps) / entry.baselineNps - 1;
+            bool slower = IsSlower(entry, options.tolerance);
+            logChangeSum += std::log1p(change);
+            ++compared;
+            std::cout << "  baseline " << std::setw(8) << entry.baselineNps / 1e6 << " Mnps "
+                      << std::showpos << std::setw(6) << change * 100 << std::noshowpos << "%"
+                      << (slower && !options.update ? "  SLOWER" : "");
+        }
+        std::cout << std::endl;
+    }
+
+    double meanChange = compared ? std::expm1(logChangeSum / compared) : 0;
+    if (compared) {
+        std::cout << "Geometric mean change: " << std::showpos << meanChange * 100
+                  << std::noshowpos << "% over " << compared << " positions" << std::endl;
+    }
+    return meanChange;
+}
+
+static void PrintUsage(const char* program) {
+    std::cerr
+        << "usage: " << program << " [options]\n"
+        << "  --baseline <file>      baseline EPD file (default: " PERFT_BASELINE_PATH ")\n"
+        << "  --tolerance <percent>  allowed slowdown of the geometric mean against the baseline (default: 10)\n"
+        << "  --min-time <seconds>   minimum time spent on each position (default: 1)\n"
+        << "  --update               record the measured nps as the new baseline; the nps are absolute,\n"
+        << "                         so run it on the machine that runs the comparison\n";
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--baseline") == 0 && i + 1 < argc)         options.baselinePath = argv[++i];
+        else if (std::strcmp(arg, "--tolerance") == 0 && i + 1 < argc)   options.tolerance = std::atof(argv[++i]) / 100;
+        else if (std::strcmp(arg, "--min-time") == 0 && i + 1 < argc)    options.minSeconds = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--update") == 0)                      options.update = true;
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.tolerance < 0 || options.minSeconds < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Entry> entries;
+    try {
+        entries = ReadBaseline(options.baselinePath);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int wrongCounts = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    double meanChange = MeasureAll(entries, options, wrongCounts);
+    // A slowdown of the whole run has to reproduce as well, the machine may have been busy for a while.
+    // The second pass keeps the faster of the two measurements of each position.
+    if (!wrongCounts && !options.update && meanChange < -options.tolerance) {
+        std::cout << "Measuring again" << std::endl;
+        meanChange = MeasureAll(entries, options, wrongCounts);
+    }
+    if (wrongCounts) {
+        std::cout << "FAILED: " << wrongCounts << " wrong node count(s)" << std::endl;
+        return 1;
+    }
+    if (options.update) {
+        try {
+            WriteBaseline(options.baselinePath, entries);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Baseline updated: " << options.baselinePath << std::endl;
+        return 0;
+    }
+    if (meanChange < -options.tolerance) {
+        std::cout << "FAILED: geometric mean more than " << options.tolerance * 100
+                  << "% slower than the baseline" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
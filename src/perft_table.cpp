@@ -0,0 +1,12 @@
+#include "perft_table.hpp"
+
+#include <bit>
+#include <stdexcept>
+
+PerftTable::PerftTable(size_t megabytes) {
+    size_t entries = megabytes * 1024 * 1024 / sizeof(Entry);
+    if (entries == 0) throw std::invalid_argument("Perft table size must be at least 1 MB");
+    entries = std::bit_floor(entries);
+    mTable = std::make_unique<Entry[]>(entries);
+    mMask = entries - 1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "zobrist_hash.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Caches perft node counts by (position, depth)
+ * Lock-free and shared between threads: each entry stores the key XOR the count next to the count,
+ * so an entry torn by concurrent writes fails the key check instead of returning a wrong count
+ * See https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+ */
+class PerftTable {
+public:
+    explicit PerftTable(size_t megabytes);
+
+    bool Probe(ZobristHash hash, int depth, uint64_t& nodes) const;
+    void Store(ZobristHash hash, int depth, uint64_t nodes);
+
+    size_t GetSize() const { return mMask + 1; }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> keyXorNodes;
+        std::atomic<uint64_t> nodes;
+    };
+
+    std::unique_ptr<Entry[]> mTable;
+    uint64_t mMask;
+
+    // The depth is folded into the key so that one position can be stored for several depths
+    static uint64_t KeyOf(ZobristHash hash, int depth) {
+        return ZobristHash::HashType(hash) ^ (uint64_t(depth) * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+inline bool PerftTable::Probe(ZobristHash hash, int depth, uint64_t& nodes) const {
+    uint64_t key = KeyOf(hash, depth);
+    const Entry& entry = mTable[key & mMask];
+    uint64_t storedNodes = entry.nodes.load(std::memory_order_relaxed);
+    uint64_t storedKey = entry.keyXorNodes.load(std::memory_order_relaxed) ^ storedNodes;
+    if (storedKey != key) return false;
+    nodes = storedNodes;
+    return true;
+}
+
+inline void PerftTable::Store(ZobristHash hash, int depth, uint64_t nodes) {
+    uint64_t key = KeyOf(hash, depth);
+    Entry& entry = mTable[key & mMask];
+    entry.keyXorNodes.store(key ^ nodes, std::memory_order_relaxed);
+    entry.nodes.store(nodes, std::memory_order_relaxed);
+}
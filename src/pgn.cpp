@@ -0,0 +1,219 @@
+#include "pgn.hpp"
+#include "san.hpp"
+
+#include <cstring>
+
+static constexpr std::string_view START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const char* ToString(PgnStatus status) {
+    switch (status) {
+        case PgnStatus::Ok:                     return "ok";
+        case PgnStatus::InvalidTag:             return "invalid tag";
+        case PgnStatus::InvalidFen:             return "invalid FEN tag";
+        case PgnStatus::IllegalMove:            return "illegal move";
+        case PgnStatus::TooLong:                return "too many moves";
+        case PgnStatus::UnterminatedComment:    return "unterminated comment";
+    }
+    return "unknown";
+}
+
+static bool IsResult(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+std::string_view PgnGame::GetTag(std::string_view name) const {
+    for (uint8_t i = 0; i < tagsNum; ++i) {
+        if (tags[i].name == name) return tags[i].value;
+    }
+    return {};
+}
+
+PgnReader::PgnReader(const std::string& path) : mFile(path) {
+    mCursor = mFile.GetData();
+    mEnd    = mCursor + mFile.GetSize();
+}
+
+void PgnReader::SkipSpaces() {
+    for (; mCursor < mEnd; ++mCursor) {
+        char c = *mCursor;
+        if (c == '\n')                                  ++mLineNumber;
+        else if (c != ' ' && c != '\t' && c != '\r')    return;
+    }
+}
+
+void PgnReader::SkipLine() {
+    const char* lineEnd = static_cast<const char*>(std::memchr(mCursor, '\n', mEnd - mCursor));
+    if (!lineEnd) {
+        mCursor = mEnd;
+        return;
+    }
+    mCursor = lineEnd + 1;
+    ++mLineNumber;
+}
+
+// Skips a {...} comment starting at the cursor; returns false if it is not closed
+bool PgnReader::SkipComment() {
+    for (++mCursor; mCursor < mEnd; ++mCursor) {
+        if (*mCursor == '\n') ++mLineNumber;
+        else if (*mCursor == '}') {
+            ++mCursor;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Skips a (...) variation starting at the cursor, including nested variations and comments
+bool PgnReader::SkipVariation() {
+    int depth = 0;
+    while (mCursor < mEnd) {
+        char c = *mCursor;
+        if (c == '{') {
+            if (!SkipComment()) return false;
+            continue;
+        }
+        if (c == ';')           SkipLine();
+        else {
+            if (c == '\n')      ++mLineNumber;
+            else if (c == '(')  ++depth;
+            else if (c == ')' && --depth == 0) {
+                ++mCursor;
+                return true;
+            }
+            ++mCursor;
+        }
+    }
+    return false;
+}
+
+// Skips to the first tag of the next game
+void PgnReader::SkipGame(bool inTags) {
+    if (inTags) {
+        while (mCursor < mEnd && *mCursor == '[') SkipLine();
+    }
+    while (mCursor < mEnd && *mCursor != '[') SkipLine();
+}
+
+// [Name "Value"] starting at the cursor
+bool PgnReader::ReadTag(PgnGame::Tag& tag) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(mCursor, '\n', mEnd - mCursor));
+    std::string_view line(mCursor, (lineEnd ? lineEnd : mEnd) - mCursor);
+
+    std::size_t nameEnd = line.find_first_of(" \t\"", 1);
+    if (nameEnd == std::string_view::npos) return false;
+    tag.name = line.substr(1, nameEnd - 1);
+
+    std::size_t open = line.find('"', nameEnd);
+    if (open == std::string_view::npos) return false;
+    std::size_t close = open + 1;
+    while (close < line.size() && line[close] != '"') close += line[close] == '\\' ? 2 : 1;
+    if (close >= line.size()) return false;
+    tag.value = line.substr(open + 1, close - open - 1);
+
+    std::size_t bracket = line.find(']', close);
+    if (bracket == std::string_view::npos || tag.name.empty()) return false;
+    mCursor += bracket + 1;
+    return true;
+}
+
+// A symbol of the movetext: SAN, move number, NAG or result
+std::string_view PgnReader::ReadToken() {
+    const char* begin = mCursor;
+    while (mCursor < mEnd && !std::strchr(" \t\r\n{}();[]", *mCursor)) ++mCursor;
+    return std::string_view(begin, mCursor - begin);
+}
+
+bool PgnReader::Next(Position& pos, PgnGame& game, PgnStatus& status, const PgnMoveCallback& onMove) {
+    game.tagsNum = 0;
+    game.result = {};
+    game.moves.clear();
+    game.illegalMove = {};
+
+    SkipSpaces();
+    if (mCursor == mEnd) return false;
+    mGameLineNumber = mLineNumber;
+
+    while (mCursor < mEnd && *mCursor == '[') {
+        PgnGame::Tag tag;
+        if (!ReadTag(tag)) {
+            status = PgnStatus::InvalidTag;
+            SkipGame(true);
+            return true;
+        }
+        if (game.tagsNum < PgnGame::MAX_TAGS) game.tags[game.tagsNum++] = tag;
+        SkipSpaces();
+    }
+
+    std::string_view fen = game.GetTag("FEN");
+    if (fen.empty()) fen = START_FEN;
+    if (pos.ParseFEN(fen) != FenStatus::Ok) {
+        status = PgnStatus::InvalidFen;
+        SkipGame(false);
+        return true;
+    }
+
+    status = ReadMoves(pos, game, onMove);
+    if (status != PgnStatus::Ok) SkipGame(false);
+    return true;
+}
+
+PgnStatus PgnReader::ReadMoves(Position& pos, PgnGame& game, const PgnMoveCallback& onMove) {
+    while (true) {
+        SkipSpaces();
+        if (mCursor == mEnd) return PgnStatus::Ok;
+
+        switch (*mCursor) {
+            case '[':
+                // The next game, this one has no termination marker
+                return PgnStatus::Ok;
+            case '{':
+                if (!SkipComment()) return PgnStatus::UnterminatedComment;
+                continue;
+            case '(':
+                if (!SkipVariation()) return PgnStatus::UnterminatedComment;
+                continue;
+            case ';':
+                SkipLine();
+                continue;
+            case '%':
+                if (AtLineStart()) {
+                    SkipLine();
+                    continue;
+                }
+                break;
+            case ')': case '}': case ']':
+                ++mCursor;
+                continue;
+        }
+
+        std::string_view token = ReadToken();
+        if (token.empty()) {
+            ++mCursor;
+            continue;
+        }
+        if (IsResult(token)) {
+            game.result = token;
+            return PgnStatus::Ok;
+        }
+        if (token[0] == '$') continue;
+
+        // Move numbers, possibly glued to the move as in "12.e4" or "12...Nf6"
+        std::size_t digits = 0;
+        while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') ++digits;
+        std::size_t dots = digits;
+        while (dots < token.size() && token[dots] == '.') ++dots;
+        if (dots > digits) token.remove_prefix(dots);
+        if (token.empty()) continue;
+
+        Move move = ParseSAN(pos, token);
+        if (move == Move::NewNone()) {
+            game.illegalMove = token;
+            return PgnStatus::IllegalMove;
+        }
+        if (game.moves.size() == Position::MAX_HALF_MOVES) return PgnStatus::TooLong;
+
+        if (onMove) onMove(pos, move);
+        pos.DoMove(move);
+        game.moves.push_back(move);
+    }
+}
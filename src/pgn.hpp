@@ -0,0 +1,82 @@
+#pragma once
+
+#include "position.hpp"
+#include "mapped_file.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Result of reading one PGN game
+enum class PgnStatus : uint8_t {
+    Ok,
+    InvalidTag,
+    InvalidFen,
+    IllegalMove,
+    TooLong,
+    UnterminatedComment
+};
+
+const char* ToString(PgnStatus status);
+
+/**
+ * Tags and mainline of a PGN game
+ * All views point into the memory-mapped file; tag values are kept as written (with escapes)
+ * See https://www.chessprogramming.org/Portable_Game_Notation
+ */
+struct PgnGame {
+    static constexpr uint8_t MAX_TAGS = 32;
+
+    struct Tag {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    Array<Tag, MAX_TAGS> tags;                      // Further tags are skipped
+    uint8_t tagsNum = 0;
+    std::string_view result;                        // Termination marker (1-0, 0-1, 1/2-1/2, *), empty if missing
+    std::vector<Move> moves;                        // Mainline; keeps its capacity from game to game
+    std::string_view illegalMove;                   // Token of an IllegalMove error
+
+    std::string_view GetTag(std::string_view name) const;
+};
+
+// Called with the position before each mainline move
+using PgnMoveCallback = std::function<void(const Position& pos, Move move)>;
+
+/**
+ * Streams the games of a memory-mapped PGN file
+ * Comments, variations, NAGs and move numbers are skipped without allocating
+ */
+class PgnReader {
+public:
+    explicit PgnReader(const std::string& path);
+
+    // Reads the tags of the next game and plays its mainline on pos, starting from the FEN tag if there is one
+    // After an error pos holds the position before the offending move and the rest of the game is skipped
+    // Returns false at the end of the file
+    bool Next(Position& pos, PgnGame& game, PgnStatus& status, const PgnMoveCallback& onMove = {});
+
+    // Line of the file on which the last game read starts
+    std::size_t GetLineNumber() const   { return mGameLineNumber; }
+
+private:
+    MappedFile mFile;
+    const char* mCursor;
+    const char* mEnd;
+    std::size_t mLineNumber = 1;
+    std::size_t mGameLineNumber = 0;
+
+    bool AtLineStart() const { return mCursor == mFile.GetData() || mCursor[-1] == '\n'; }
+
+    void SkipSpaces();
+    void SkipLine();
+    bool SkipComment();
+    bool SkipVariation();
+    void SkipGame(bool inTags);
+    bool ReadTag(PgnGame::Tag& tag);
+    std::string_view ReadToken();
+    PgnStatus ReadMoves(Position& pos, PgnGame& game, const PgnMoveCallback& onMove);
+
+};
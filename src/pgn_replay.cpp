@@ -0,0 +1,85 @@
+#include "pgn.hpp"
+#include "san.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+
+// Replays every game of a PGN file and reports the ingestion speed and the games that could not be read.
+// With --check-san every move is also printed in SAN and parsed back.
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    const char* path = nullptr;
+    bool checkSan = false;
+    int maxErrors = 10;             // Reported individually
+};
+
+static void PrintUsage(const char* program) {
+    std::cerr
+        << "usage: " << program << " <file.pgn> [options]\n"
+        << "  --check-san          print every move in SAN and check that it parses back to the same move\n"
+        << "  --max-errors <n>     errors reported individually (default: 10)\n";
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--check-san") == 0)                        options.checkSan = true;
+        else if (std::strcmp(arg, "--max-errors") == 0 && i + 1 < argc)  options.maxErrors = std::atoi(argv[++i]);
+        else if (arg[0] != '-' && !options.path)                        options.path = arg;
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (!options.path) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    auto pos = std::make_unique<Position>();
+    PgnGame game;
+    PgnStatus status;
+    uint64_t games = 0, errors = 0, plies = 0, sanMismatches = 0;
+
+    // The callback sees the same position that is passed to Next, ToSAN may play and undo the move on it
+    PgnMoveCallback checkSan = [&](const Position&, Move move) {
+        std::string san = ToSAN(*pos, move);
+        if (ParseSAN(*pos, san) != move && sanMismatches++ < uint64_t(options.maxErrors)) {
+            std::cerr << pos->GetFEN() << ": " << move.ToUCI() << " printed as " << san << std::endl;
+        }
+    };
+
+    auto start = Clock::now();
+    try {
+        PgnReader reader(options.path);
+        while (reader.Next(*pos, game, status, options.checkSan ? checkSan : PgnMoveCallback())) {
+            ++games;
+            plies += game.moves.size();
+            if (status == PgnStatus::Ok) continue;
+            if (errors++ < uint64_t(options.maxErrors)) {
+                std::cerr << options.path << ":" << reader.GetLineNumber() << ": " << ToString(status);
+                if (status == PgnStatus::IllegalMove) std::cerr << " " << game.illegalMove << " in " << pos->GetFEN();
+                std::cerr << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    double seconds = std::max(std::chrono::duration<double>(Clock::now() - start).count(), 1e-9);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << games << " games, " << plies << " plies, " << errors << " with errors in " << seconds << " s\n"
+              << games / seconds << " games/s (" << games / seconds * 3600 / 1e6 << " M games/hour), "
+              << plies / seconds / 1e6 << " M plies/s" << std::endl;
+    if (options.checkSan) std::cout << sanMismatches << " SAN round trip mismatches" << std::endl;
+    return errors || sanMismatches ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "position.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Position key of the Polyglot book format (http://hgm.nubati.net/book_format.html), built from the
+ * 781 random numbers published with the format, which differ from the keys of ZobristHash
+ */
+uint64_t PolyglotKey(const Position& pos);
+
+// Checks PolyglotKey against the example keys of the format description, printing one line per position
+bool CheckPolyglotKeys(std::ostream& out);
+
+/**
+ * Polyglot opening book (.bin): 16 byte big-endian entries sorted by position key
+ * The file is memory-mapped and binary-searched in place
+ */
+class PolyglotBook {
+public:
+    struct BookMove {
+        Move move;
+        uint16_t weight;
+    };
+
+    explicit PolyglotBook(const std::string& bookPath);
+
+    // The legal book moves of the position in file order (highest weight first in well-formed books)
+    std::vector<BookMove> GetMoves(const Position& pos) const;
+    // A book move chosen with a probability proportional to its weight; Move::NewNone() when out of book
+    Move Probe(const Position& pos, std::mt19937_64& random) const;
+
+    std::size_t GetSize() const { return mFile.GetSize() / ENTRY_SIZE; }
+
+private:
+    static constexpr std::size_t ENTRY_SIZE = 16;
+
+    MappedFile mFile;
+
+    uint64_t KeyAt(std::size_t index) const;
+    static Move ToMove(const Position& pos, uint16_t polyglotMove);
+
+};
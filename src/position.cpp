@@ -1,111 +1,374 @@
 #include "position.hpp"
+#include "profile.hpp"
 
 #include <stdexcept>
 #include <cctype>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <charconv>
+
+constexpr Array<Position::MoveKind, Move::FLAGS_NUM> Position::MOVE_KINDS = [] {
+    Array<MoveKind, Move::FLAGS_NUM> kinds = {};
+    for (int flags = 0; flags < Move::FLAGS_NUM; ++flags) {
+        Move move = Move::FromRaw(flags << Move::FLAGS_SHIFT);
+        if (move.IsPromotion())             kinds[flags] = move.IsCapture() ? MoveKind::PromotionCapture : MoveKind::Promotion;
+        else if (move.IsEnPassant())        kinds[flags] = MoveKind::EnPassant;
+        else if (move.IsCapture())          kinds[flags] = MoveKind::Capture;
+        else if (move.IsKingsideCastle())   kinds[flags] = MoveKind::KingsideCastle;
+        else if (move.IsQueensideCastle())  kinds[flags] = MoveKind::QueensideCastle;
+        else if (move.IsDoublePawnPush())   kinds[flags] = MoveKind::DoublePawnPush;
+        else                                kinds[flags] = MoveKind::Quiet;
+    }
+    return kinds;
+}();
+
+void Position::DoMove(Move move) {
+    PROFILE_SCOPE(DoMove);
+    if (mSideToMove == Color::White)    DoMove<Color::White>(move);
+    else                                DoMove<Color::Black>(move);
+    assert(ZobristHashCorrect());
+}
 
+void Position::UndoMove() {
+    PROFILE_SCOPE(UndoMove);
+    const RestoreInfo& restoreInfo = mHistory[--mHistoryNext];
+    if (mSideToMove == Color::Black)    UndoMove<Color::White>(restoreInfo);
+    else                                UndoMove<Color::Black>(restoreInfo);
+    assert(ZobristHashCorrect());
+}
+
+template <Color color>
 void Position::DoMove(Move move) {
+    switch (MOVE_KINDS[move.GetFlags()]) {
+    case MoveKind::Quiet:               DoMove<color, MoveKind::Quiet>(move); break;
+    case MoveKind::DoublePawnPush:      DoMove<color, MoveKind::DoublePawnPush>(move); break;
+    case MoveKind::Capture:             DoMove<color, MoveKind::Capture>(move); break;
+    case MoveKind::EnPassant:           DoMove<color, MoveKind::EnPassant>(move); break;
+    case MoveKind::KingsideCastle:      DoMove<color, MoveKind::KingsideCastle>(move); break;
+    case MoveKind::QueensideCastle:     DoMove<color, MoveKind::QueensideCastle>(move); break;
+    case MoveKind::Promotion:           DoMove<color, MoveKind::Promotion>(move); break;
+    case MoveKind::PromotionCapture:    DoMove<color, MoveKind::PromotionCapture>(move); break;
+    }
+}
+
+template <Color color>
+void Position::UndoMove(const RestoreInfo& restoreInfo) {
+    switch (MOVE_KINDS[restoreInfo.move.GetFlags()]) {
+    case MoveKind::Quiet:               UndoMove<color, MoveKind::Quiet>(restoreInfo); break;
+    case MoveKind::DoublePawnPush:      UndoMove<color, MoveKind::DoublePawnPush>(restoreInfo); break;
+    case MoveKind::Capture:             UndoMove<color, MoveKind::Capture>(restoreInfo); break;
+    case MoveKind::EnPassant:           UndoMove<color, MoveKind::EnPassant>(restoreInfo); break;
+    case MoveKind::KingsideCastle:      UndoMove<color, MoveKind::KingsideCastle>(restoreInfo); break;
+    case MoveKind::QueensideCastle:     UndoMove<color, MoveKind::QueensideCastle>(restoreInfo); break;
+    case MoveKind::Promotion:           UndoMove<color, MoveKind::Promotion>(restoreInfo); break;
+    case MoveKind::PromotionCapture:    UndoMove<color, MoveKind::PromotionCapture>(restoreInfo); break;
+    }
+}
+
+template <Color color, Position::MoveKind kind>
+void Position::DoMove(Move move) {
+    constexpr bool isCapture = kind == MoveKind::Capture || kind == MoveKind::PromotionCapture;
     Square from = move.GetFrom();
     Square to = move.GetTo();
 
-    RestoreInfo& restoreInfo            = mHistory[mHistoryNext++];
-    restoreInfo.move                    = move;
-    restoreInfo.capturedPiece           = move.IsCapture() ? GetBoard(to) : Piece::None;
-    restoreInfo.enPassant               = mEnPassant;
-    restoreInfo.castlingRights          = mCastlingRights;
-    restoreInfo.reversableHalfMovesCnt  = mReversableHalfMovesCnt;
-    restoreInfo.attacks                 = mAttacks;
-    restoreInfo.pinned                  = mPinned;
-    restoreInfo.kingAttackers           = mKingAttackers;
-    restoreInfo.checkSquares            = mCheckSquares;
-    restoreInfo.zobristHash             = mZobristHash;
+    RestoreInfo& restoreInfo              = mHistory[mHistoryNext++];
+    restoreInfo.move                      = move;
+    restoreInfo.capturedPiece             = isCapture ? GetBoard(to) : Piece::None;
+    restoreInfo.enPassant                 = mEnPassant;
+    restoreInfo.castlingRights            = mCastlingRights;
+    restoreInfo.reversableHalfMovesCnt    = mReversableHalfMovesCnt;
+    restoreInfo.attacks                   = mAttacks;
+    restoreInfo.pinned                    = mPinned;
+    restoreInfo.kingAttackers             = mKingAttackers;
+    restoreInfo.checkSquares              = mCheckSquares;
+    restoreInfo.checkingSquares           = mCheckingSquares;
+    restoreInfo.discoveredCheckCandidates = mDiscoveredCheckCandidates;
+    restoreInfo.zobristHash               = mZobristHash;
 
     if (mEnPassant != Square::None) NullifyEnPassant();
 
-    if (move.IsQuiet()) {
+    if constexpr (kind == MoveKind::Quiet) {
         MovePiece(from, to);
-        if (move.IsDoublePawnPush()) {
-            SetEnPassant(MiddleOf(from, to));
-        }
     }
-    else if (move.IsNormalCapture()) {
+    else if constexpr (kind == MoveKind::DoublePawnPush) {
+        MovePiece(from, to);
+        SetEnPassant(MiddleOf(from, to));
+    }
+    else if constexpr (kind == MoveKind::Capture) {
         CapturePiece(from, to);
     }
-    else if (move.IsEnPassant()) {
-        Square captured = MakeSquare(FileOf(to), RankOf(from));
-        RemovePiece(captured);
+    else if constexpr (kind == MoveKind::EnPassant) {
+        RemovePiece(MakeSquare(FileOf(to), RankOf(from)));
         MovePiece(from, to);
     }
-    else if (move.IsCastle()) {
-        BoardFile rookFile = move.IsQueensideCastle() ? BoardFile::A : BoardFile::H;
-        Square rook = MakeSquare(rookFile, RankOf(from));
+    else if constexpr (kind == MoveKind::KingsideCastle || kind == MoveKind::QueensideCastle) {
+        constexpr BoardFile rookFile = kind == MoveKind::QueensideCastle ? BoardFile::A : BoardFile::H;
         MovePiece(from, to);
-        MovePiece(rook, MiddleOf(from, to));
+        MovePiece(MakeSquare(rookFile, RankOf(from)), MiddleOf(from, to));
     }
     else {
-        assert(move.IsPromotion());
-        if (move.IsCapture()) RemovePiece(to);
+        if constexpr (isCapture) RemovePiece(to);
         RemovePiece(from);
-        AddPiece(MakePiece(GetSideToMove(), move.GetPromotionType()), to);
+        AddPiece(MakePiece(color, move.GetPromotionType()), to);
     }
 
-    if (mSideToMove == Color::White)    UpdateCastlingRights<Color::White>(from, to);
-    else                                UpdateCastlingRights<Color::Black>(from, to);
+    // Pawn pushes and en passant captures never touch a king or rook square
+    if constexpr (kind == MoveKind::KingsideCastle || kind == MoveKind::QueensideCastle) {
+        mZobristHash.SwitchCastlingRights(mCastlingRights);
+        mCastlingRights.ForbidCastling<color>();
+        mZobristHash.SwitchCastlingRights(mCastlingRights);
+    }
+    else if constexpr (kind != MoveKind::DoublePawnPush && kind != MoveKind::EnPassant) {
+        if (mCastlingRights != CastlingRights::NONE) UpdateCastlingRights<color>(from, to);
+    }
 
-    if (move.IsQuiet()) {
+    if constexpr (kind == MoveKind::Quiet) {
+        if (PieceTypeOf(GetBoard(to)) != PieceType::Pawn)   ++mReversableHalfMovesCnt;
+        else                                                mReversableHalfMovesCnt = 0;
+    }
+    else if constexpr (kind == MoveKind::KingsideCastle || kind == MoveKind::QueensideCastle) {
         ++mReversableHalfMovesCnt;
     }
     else {
         mReversableHalfMovesCnt = 0;
     }
-    if (GetSideToMove() == Color::Black) ++mMoveNum;
+    if constexpr (color == Color::Black) ++mMoveNum;
 
     SwitchSideToMove();
-    UpdateAuxiliaryInfo();
-
-    assert(ZobristHashCorrect());
+    UpdateAuxiliaryInfo<~color>();
 }
 
-void Position::UndoMove() {
-    RestoreInfo& restoreInfo = mHistory[--mHistoryNext];
-
+template <Color color, Position::MoveKind kind>
+void Position::UndoMove(const RestoreInfo& restoreInfo) {
     Square from = restoreInfo.move.GetFrom();
     Square to = restoreInfo.move.GetTo();
-    if (restoreInfo.move.IsQuiet() || restoreInfo.move.IsNormalCapture()) {
+    if constexpr (kind == MoveKind::Quiet || kind == MoveKind::DoublePawnPush) {
         MovePiece(to, from);
     }
-    else if (restoreInfo.move.IsEnPassant()) {
-        Square captured = MakeSquare(FileOf(to), RankOf(from));
+    else if constexpr (kind == MoveKind::Capture) {
+        MovePiece(to, from);
+        AddPiece(restoreInfo.capturedPiece, to);
+    }
+    else if constexpr (kind == MoveKind::EnPassant) {
         MovePiece(to, from);
-        AddPiece(MakePiece(mSideToMove, PieceType::Pawn), captured);
+        AddPiece(MakePiece(~color, PieceType::Pawn), MakeSquare(FileOf(to), RankOf(from)));
     }
-    else if (restoreInfo.move.IsCastle()) {
-        BoardFile rookFile = restoreInfo.move.IsQueensideCastle() ? BoardFile::A : BoardFile::H;
-        Square rook = MakeSquare(rookFile, RankOf(from));
+    else if constexpr (kind == MoveKind::KingsideCastle || kind == MoveKind::QueensideCastle) {
+        constexpr BoardFile rookFile = kind == MoveKind::QueensideCastle ? BoardFile::A : BoardFile::H;
         MovePiece(to, from);
-        MovePiece(MiddleOf(from, to), rook);
+        MovePiece(MiddleOf(from, to), MakeSquare(rookFile, RankOf(from)));
     }
     else {
-        assert(restoreInfo.move.IsPromotion());
         RemovePiece(to);
-        AddPiece(MakePiece(~mSideToMove, PieceType::Pawn), from);
+        AddPiece(MakePiece(color, PieceType::Pawn), from);
+        if constexpr (kind == MoveKind::PromotionCapture) AddPiece(restoreInfo.capturedPiece, to);
     }
 
-    if (restoreInfo.capturedPiece != Piece::None) AddPiece(restoreInfo.capturedPiece, to);
-    if (mSideToMove == Color::White) mMoveNum--;
+    if constexpr (color == Color::Black) mMoveNum--;
     SwitchSideToMove();
 
-    mEnPassant              = restoreInfo.enPassant;
-    mCastlingRights         = restoreInfo.castlingRights;
-    mReversableHalfMovesCnt = restoreInfo.reversableHalfMovesCnt;
-    mAttacks                = restoreInfo.attacks;
-    mPinned                 = restoreInfo.pinned;
-    mKingAttackers          = restoreInfo.kingAttackers;
-    mCheckSquares           = restoreInfo.checkSquares;
-    mZobristHash            = restoreInfo.zobristHash;
+    mEnPassant                 = restoreInfo.enPassant;
+    mCastlingRights            = restoreInfo.castlingRights;
+    mReversableHalfMovesCnt    = restoreInfo.reversableHalfMovesCnt;
+    mAttacks                   = restoreInfo.attacks;
+    mPinned                    = restoreInfo.pinned;
+    mKingAttackers             = restoreInfo.kingAttackers;
+    mCheckSquares              = restoreInfo.checkSquares;
+    mCheckingSquares           = restoreInfo.checkingSquares;
+    mDiscoveredCheckCandidates = restoreInfo.discoveredCheckCandidates;
+    mZobristHash               = restoreInfo.zobristHash;
+}
+
+bool Position::IsPseudoLegal(Move move) const {
+    if (mSideToMove == Color::White)    return IsPseudoLegal<Color::White>(move);
+    else                                return IsPseudoLegal<Color::Black>(move);
+}
 
-    assert(ZobristHashCorrect());
+bool Position::IsLegal(Move move) const {
+    if (mSideToMove == Color::White)    return IsLegal<Color::White>(move);
+    else                                return IsLegal<Color::Black>(move);
+}
+
+bool Position::GivesCheck(Move move) const {
+    if (mSideToMove == Color::White)    return GivesCheck<Color::White>(move);
+    else                                return GivesCheck<Color::Black>(move);
+}
+
+bool Position::IsRepetition() const {
+    // Only positions with the same side to move can repeat, and none before the last irreversible move
+    uint32_t plies = std::min(mReversableHalfMovesCnt, mHistoryNext);
+    for (uint32_t ply = 4; ply <= plies; ply += 2) {
+        if (mHistory[mHistoryNext - ply].zobristHash == mZobristHash) return true;
+    }
+    return false;
+}
+
+bool Position::IsInsufficientMaterial() const {
+    Bitboard minors = BB::NONE;
+    for (Color color : { Color::White, Color::Black }) {
+        if (GetPiecesBB(color, PieceType::Pawn) | GetPiecesBB(color, PieceType::Rook) | GetPiecesBB(color, PieceType::Queen)) return false;
+        minors |= GetPiecesBB(color, PieceType::Knight) | GetPiecesBB(color, PieceType::Bishop);
+    }
+    return !BB::AtLeast2(minors);
+}
+
+template <Color color>
+bool Position::IsPseudoLegal(Move move) const {
+    constexpr Color other                   = ~color;
+    constexpr Direction Forward             = color == Color::White ? Direction::Up : Direction::Down;
+    constexpr BoardRank MySide              = color == Color::White ? BoardRank::R1 : BoardRank::R8;
+    constexpr Bitboard Rank2BB              = BB::RankBB(color == Color::White ? BoardRank::R2 : BoardRank::R7);
+    constexpr Bitboard PromotionRankBB      = BB::RankBB(color == Color::White ? BoardRank::R8 : BoardRank::R1);
+    constexpr Square MyKing                 = MakeSquare(BoardFile::E, MySide);
+    constexpr Bitboard KingsideGapBB        = 
+        BB::SquareBB(MakeSquare(BoardFile::F, MySide)) |
+        BB::SquareBB(MakeSquare(BoardFile::G, MySide));
+    constexpr Bitboard QueensideGapBB       = 
+        BB::SquareBB(MakeSquare(BoardFile::B, MySide)) |
+        BB::SquareBB(MakeSquare(BoardFile::C, MySide)) |
+        BB::SquareBB(MakeSquare(BoardFile::D, MySide));
+
+    Square from     = move.GetFrom();
+    Square to       = move.GetTo();
+    Bitboard toBB   = BB::SquareBB(to);
+    Piece piece     = GetBoard(from);
+    Piece captured  = GetBoard(to);
+
+    if (from == to || piece == Piece::None || ColorOf(piece) != color) return false;
+
+    // Flags must describe a capture exactly when an opposing piece (other than the king) is taken
+    if (move.IsEnPassant() || !move.IsCapture()) {
+        if (captured != Piece::None) return false;
+    }
+    else {
+        if (!move.IsPromotion() && !move.IsNormalCapture()) return false; // Unused flag combination
+        if (captured == Piece::None || ColorOf(captured) != other) return false;
+        if (PieceTypeOf(captured) == PieceType::King) return false;
+    }
+
+    if (PieceTypeOf(piece) == PieceType::Pawn) {
+        if (move.IsCastle()) return false;
+        if (move.IsPromotion() != ((toBB & PromotionRankBB) != 0)) return false;
+        if (move.IsEnPassant()) return to == mEnPassant && (BB::PawnAttacks<color>(from) & toBB);
+        if (move.IsCapture()) return BB::PawnAttacks<color>(from) & toBB;
+        if (move.IsDoublePawnPush()) {
+            return 
+                (BB::SquareBB(from) & Rank2BB) && 
+                to == from + Forward + Forward && 
+                GetBoard(from + Forward) == Piece::None;
+        }
+        return to == from + Forward;
+    }
+
+    if (move.IsPromotion() || move.IsEnPassant() || move.IsDoublePawnPush()) return false;
+
+    if (move.IsCastle()) {
+        if (PieceTypeOf(piece) != PieceType::King || from != MyKing) return false;
+        if (move.IsKingsideCastle()) {
+            return 
+                to == MakeSquare(BoardFile::G, MySide) && 
+                mCastlingRights.CanCastleKingside<color>() && 
+                !(GetOccupancy() & KingsideGapBB);
+        } 
+        else {
+            return 
+                to == MakeSquare(BoardFile::C, MySide) && 
+                mCastlingRights.CanCastleQueenside<color>() && 
+                !(GetOccupancy() & QueensideGapBB);
+        }
+    }
+
+    return BB::Attacks(PieceTypeOf(piece), from, GetOccupancy()) & toBB;
+}
+
+template <Color color>
+bool Position::IsLegal(Move move) const {
+    constexpr Color other               = ~color;
+    constexpr BoardRank MySide          = color == Color::White ? BoardRank::R1 : BoardRank::R8;
+    constexpr Bitboard KingsideTravelBB = 
+        BB::SquareBB(MakeSquare(BoardFile::F, MySide)) |
+        BB::SquareBB(MakeSquare(BoardFile::G, MySide));
+    constexpr Bitboard QueensideTravelBB = 
+        BB::SquareBB(MakeSquare(BoardFile::C, MySide)) |
+        BB::SquareBB(MakeSquare(BoardFile::D, MySide));
+
+    assert(IsPseudoLegal(move));
+
+    Square from         = move.GetFrom();
+    Square to           = move.GetTo();
+    Bitboard toBB       = BB::SquareBB(to);
+    Square kingSquare   = GetKingPosition(color);
+
+    if (move.IsCastle()) {
+        Bitboard travelBB = move.IsKingsideCastle() ? KingsideTravelBB : QueensideTravelBB;
+        return !IsCheck() && !(GetAttacks(other) & travelBB);
+    }
+    if (from == kingSquare) {
+        return !(mCheckSquares & toBB);
+    }
+
+    // Only the king can escape a double check
+    if (IsDoubleCheck()) return false;
+
+    if (move.IsEnPassant()) {
+        Square captured = MakeSquare(FileOf(to), RankOf(from));
+        if (IsCheck() && !(mKingAttackers & BB::SquareBB(captured))) return false;
+
+        // Both pawns leave the rank of the king at once
+        Bitboard occupancyAfter = GetOccupancy() ^ (BB::SquareBB(from) | toBB | BB::SquareBB(captured));
+        Bitboard straightSliders = GetPiecesBB(other, PieceType::Rook) | GetPiecesBB(other, PieceType::Queen);
+        if (BB::Attacks<PieceType::Rook>(kingSquare, occupancyAfter) & straightSliders) return false;
+    }
+    else if (IsCheck()) {
+        // Block or capture the attacker
+        Bitboard allowedTargets = BB::Between(kingSquare, BB::Lsb(mKingAttackers)) | mKingAttackers;
+        if (!(allowedTargets & toBB)) return false;
+    }
+
+    return !(GetPinned(color) & BB::SquareBB(from)) || BB::OnLine(from, to, kingSquare);
+}
+
+template <Color color>
+bool Position::GivesCheck(Move move) const {
+    constexpr Color other = ~color;
+
+    Square from             = move.GetFrom();
+    Square to               = move.GetTo();
+    Bitboard fromBB         = BB::SquareBB(from);
+    Bitboard toBB           = BB::SquareBB(to);
+    Square theirKing        = GetKingPosition(other);
+    Bitboard theirKingBB    = BB::SquareBB(theirKing);
+    PieceType type          = PieceTypeOf(GetBoard(from));
+
+    assert(GetBoard(from) != Piece::None && ColorOf(GetBoard(from)) == color);
+
+    // Direct check
+    if (!move.IsPromotion() && (GetCheckingSquares(type) & toBB)) return true;
+
+    // Discovered check
+    if ((mDiscoveredCheckCandidates & fromBB) && !BB::OnLine(from, to, theirKing)) return true;
+
+    if (move.IsPromotion()) {
+        return BB::Attacks(move.GetPromotionType(), to, GetOccupancy() ^ fromBB) & theirKingBB;
+    }
+    if (move.IsEnPassant()) {
+        // The captured pawn may uncover a slider as well
+        Square captured     = MakeSquare(FileOf(to), RankOf(from));
+        Bitboard occupancy  = GetOccupancy() ^ (fromBB | toBB | BB::SquareBB(captured));
+        Bitboard queens     = GetPiecesBB(color, PieceType::Queen);
+        return 
+            (BB::Attacks<PieceType::Rook>(theirKing, occupancy) & (queens | GetPiecesBB(color, PieceType::Rook))) |
+            (BB::Attacks<PieceType::Bishop>(theirKing, occupancy) & (queens | GetPiecesBB(color, PieceType::Bishop)));
+    }
+    if (move.IsCastle()) {
+        BoardFile rookFile  = move.IsQueensideCastle() ? BoardFile::A : BoardFile::H;
+        Square rookFrom     = MakeSquare(rookFile, RankOf(from));
+        Square rookTo       = MiddleOf(from, to);
+        Bitboard occupancy  = GetOccupancy() ^ (fromBB | toBB | BB::SquareBB(rookFrom) | BB::SquareBB(rookTo));
+        return BB::Attacks<PieceType::Rook>(rookTo, occupancy) & theirKingBB;
+    }
+    return false;
 }
 
 std::string Position::GetFEN() const {
@@ -151,7 +414,7 @@ std::string Position::GetFEN() const {
     }
 
     if (mEnPassant != Square::None) {
-        s << ' ' << ('a' + ToInt(FileOf(mEnPassant))) << ('1' + ToInt(RankOf(mEnPassant)));
+        s << ' ' << char('a' + ToInt(FileOf(mEnPassant))) << char('1' + ToInt(RankOf(mEnPassant)));
     } else {
         s << ' ' << '-';
     }
@@ -161,140 +424,262 @@ std::string Position::GetFEN() const {
     return s.str();
 }
 
-void Position::InitFromFEN(const char *fen) {
+PackedPosition Position::GetPacked() const {
+    PackedPosition packed = {};
+    packed.occupancy = GetOccupancy();
+
+    uint8_t index = 0;
+    for (Bitboard occupancy = packed.occupancy; occupancy; ++index) {
+        packed.SetPiece(index, ToInt(GetBoard(BB::PopLsb(occupancy))));
+    }
+
+    packed.sideToMove           = ToInt(mSideToMove);
+    packed.castlingRights       = GetCastlingRights();
+    packed.enPassant            = ToInt(mEnPassant);
+    packed.reversableHalfMoves  = std::min<uint32_t>(mReversableHalfMovesCnt, 255);
+    packed.moveNum              = mMoveNum;
+    return packed;
+}
+
+Position::Position(const PackedPosition& packed) {
+    if (!InitFromPacked(packed)) throw std::invalid_argument("Malformed packed position");
+}
+
+bool Position::InitFromPacked(const PackedPosition& packed) {
+    Clear();
+
+    if (BB::Count1s(packed.occupancy) > PackedPosition::MAX_PIECES) return false;
+    uint8_t index = 0;
+    for (Bitboard occupancy = packed.occupancy; occupancy; ++index) {
+        Piece piece = static_cast<Piece>(packed.GetPiece(index));
+        if (!IsValid(piece)) return false;
+        AddPiece(piece, BB::PopLsb(occupancy));
+    }
+    if (BB::Count1s(GetPiecesBB(Color::White, PieceType::King)) != 1) return false;
+    if (BB::Count1s(GetPiecesBB(Color::Black, PieceType::King)) != 1) return false;
+
+    if (packed.sideToMove > ToInt(Color::Black)) return false;
+    if (packed.sideToMove == ToInt(Color::Black)) SwitchSideToMove();
+
+    if (packed.castlingRights >= CASTLING_RIGHTS_NUM) return false;
+    mCastlingRights = packed.castlingRights;
+    if (!CastlingRightsValid()) return false;
+    mZobristHash.SwitchCastlingRights(mCastlingRights);
+
+    Square enPassant = static_cast<Square>(packed.enPassant);
+    if (enPassant != Square::None) {
+        if (!IsValid(enPassant)) return false;
+        SetEnPassant(enPassant);
+        if (!EnPassantValid()) return false;
+    }
+
+    mReversableHalfMovesCnt = packed.reversableHalfMoves;
+    mMoveNum                = packed.moveNum;
+
+    UpdateAuxiliaryInfo();
+
+    assert(ZobristHashCorrect());
+    return true;
+}
+
+void Position::Clear() {
     mPiecesBB[ToInt(Color::White)].fill(BB::NONE);
     mPiecesBB[ToInt(Color::Black)].fill(BB::NONE);
     mBoard.fill(Piece::None);
     mOccupied.fill(BB::NONE);
     mAttacks.fill(BB::NONE);
     mPinned.fill(BB::NONE);
-    
-
-    fen = InitFromFEN_PiecePosition(fen);
-    fen = InitFromFEN_ExpectSpace(fen);
+    mSideToMove     = Color::White;
+    mEnPassant      = Square::None;
+    mZobristHash    = ZobristHash();
+    mHistoryNext    = 0;
+}
 
-    fen = InitFromFEN_SideToMove(fen);
-    fen = InitFromFEN_ExpectSpace(fen);
+const char* ToString(FenStatus status) {
+    switch (status) {
+    case FenStatus::Ok:                     return "ok";
+    case FenStatus::InvalidPiecePlacement:  return "invalid piece placement";
+    case FenStatus::InvalidSideToMove:      return "expected 'w' or 'b' as active color";
+    case FenStatus::InvalidCastlingRights:  return "invalid castling rights";
+    case FenStatus::InvalidEnPassant:       return "invalid en passant";
+    case FenStatus::InvalidHalfMoveClock:   return "invalid half move clock";
+    case FenStatus::InvalidMoveNumber:      return "invalid move number";
+    case FenStatus::InvalidKings:           return "each side needs exactly one king";
+    case FenStatus::InvalidOperation:       return "invalid epd operation";
+    case FenStatus::UnterminatedString:     return "unterminated string operand";
+    case FenStatus::TooManyOperands:        return "too many operands";
+    default:                                return "unknown";
+    }
+}
 
-    fen = InitFromFEN_CastlingRights(fen);
-    fen = InitFromFEN_ExpectSpace(fen);
+static bool IsDigit(char c) {
+    return '0' <= c && c <= '9';
+}
 
-    fen = InitFromFEN_EnPassant(fen);
-    fen = InitFromFEN_ExpectSpace(fen);
+void Position::InitFromFEN(const char *fen) {
+    std::string_view view(fen);
+    FenStatus status = ParseFEN(view);
+    if (status != FenStatus::Ok) throw std::invalid_argument(std::string("Illegal fen: ") + ToString(status));
+}
 
-    fen = InitFromFEN_ReversableHalfMoves(fen);
-    fen = InitFromFEN_ExpectSpace(fen);
+FenStatus Position::ParseFEN(std::string_view& fen) {
+    Clear();
+
+    if (!ParseFEN_PiecePosition(fen))                                   return FenStatus::InvalidPiecePlacement;
+    if (!ParseFEN_ExpectSpace(fen) || !ParseFEN_SideToMove(fen))        return FenStatus::InvalidSideToMove;
+    // Move generation relies on the pieces of the castling rights and the en passant pawn being in place
+    if (!ParseFEN_ExpectSpace(fen) || !ParseFEN_CastlingRights(fen) || !CastlingRightsValid())
+        return FenStatus::InvalidCastlingRights;
+    if (!ParseFEN_ExpectSpace(fen) || !ParseFEN_EnPassant(fen) || !EnPassantValid())
+        return FenStatus::InvalidEnPassant;
+
+    // The move counters are missing in EPD
+    mReversableHalfMovesCnt = 0;
+    mMoveNum                = 1;
+    if (fen.size() >= 2 && fen[0] == ' ' && IsDigit(fen[1])) {
+        fen.remove_prefix(1);
+        if (!ParseFEN_Number(fen, mReversableHalfMovesCnt))             return FenStatus::InvalidHalfMoveClock;
+        if (fen.size() >= 2 && fen[0] == ' ' && IsDigit(fen[1])) {
+            fen.remove_prefix(1);
+            if (!ParseFEN_Number(fen, mMoveNum))                        return FenStatus::InvalidMoveNumber;
+        }
+    }
 
-    fen = InitFromFEN_MoveNum(fen);
+    if (BB::Count1s(GetPiecesBB(Color::White, PieceType::King)) != 1)   return FenStatus::InvalidKings;
+    if (BB::Count1s(GetPiecesBB(Color::Black, PieceType::King)) != 1)   return FenStatus::InvalidKings;
 
     UpdateAuxiliaryInfo();
 
     assert(ZobristHashCorrect());
+    return FenStatus::Ok;
 }
 
-const char* Position::InitFromFEN_PiecePosition(const char* fen) {
+bool Position::ParseFEN_PiecePosition(std::string_view& fen) {
     BoardRank rank = BoardRank::R8;
     BoardFile file = BoardFile::A;
-    for (; *fen && *fen != ' '; ++fen) {
-        if (*fen == '/') {
-            if (file <= BoardFile::H) 
-                throw std::invalid_argument("Illegal fen: '/' before end of rank");
-            if (rank == BoardRank::R1)
-                throw std::invalid_argument("Illegal fen: '/' after last rank");
+    for (; !fen.empty() && fen[0] != ' '; fen.remove_prefix(1)) {
+        char c = fen[0];
+        if (c == '/') {
+            if (file <= BoardFile::H) return false;     // '/' before end of rank
+            if (rank == BoardRank::R1) return false;    // '/' after last rank
             --rank; file = BoardFile::A;
         } 
         else if (file > BoardFile::H) {
-            throw std::invalid_argument("Illegal fen: rank already full, '/' expected");
+            return false;                               // Rank already full, '/' expected
         }
-        else if ('1' <= *fen && *fen <= '8') {
-            file += (*fen - '0');
-            if (file > BoardFile::H + 1)
-                throw std::invalid_argument("Illegal fen: skipped past end of rank");
+        else if ('1' <= c && c <= '8') {
+            file += (c - '0');
+            if (file > BoardFile::H + 1) return false;  // Skipped past end of rank
         }
         else { // piece
-            Color color = std::isupper(*fen) ? Color::White : Color::Black;
+            Color color = std::isupper(c) ? Color::White : Color::Black;
             PieceType type = PieceType::None;
-            switch (std::toupper(*fen)) {
+            switch (std::toupper(c)) {
                 case 'K': type = PieceType::King; break;
                 case 'Q': type = PieceType::Queen; break;
                 case 'R': type = PieceType::Rook; break;
                 case 'N': type = PieceType::Knight; break;
                 case 'B': type = PieceType::Bishop; break;
                 case 'P': type = PieceType::Pawn; break;
-                default: throw std::invalid_argument("Illegal fen: illegal piece type");
+                default: return false;
             }
             AddPiece(MakePiece(color, type), MakeSquare(file, rank));
             ++file;
         }
     }
-    return fen;
+    return rank == BoardRank::R1 && file > BoardFile::H;
 }
 
-const char* Position::InitFromFEN_SideToMove(const char* fen) {
-    if (!(*fen == 'w' || *fen == 'b')) throw std::invalid_argument("Illegal fen: expected 'w' or 'b' as active color");
-    mSideToMove = Color::White;
-    if (*fen == 'b') {
+bool Position::ParseFEN_SideToMove(std::string_view& fen) {
+    if (fen.empty() || !(fen[0] == 'w' || fen[0] == 'b')) return false;
+    if (fen[0] == 'b') {
         SwitchSideToMove();
     }
-    return fen + 1;
+    fen.remove_prefix(1);
+    return true;
 }
 
-const char* Position::InitFromFEN_CastlingRights(const char* fen) {
+bool Position::ParseFEN_CastlingRights(std::string_view& fen) {
     mCastlingRights = CastlingRights::NONE;
-    if (*fen == '-') return fen + 1;
-    if (*fen == 'K') {
+    if (fen.empty()) return false;
+    if (fen[0] == '-') {
+        mZobristHash.SwitchCastlingRights(mCastlingRights);
+        fen.remove_prefix(1);
+        return true;
+    }
+    if (!fen.empty() && fen[0] == 'K') {
         mCastlingRights.AllowCastlingKingside<Color::White>();
-        ++fen;
+        fen.remove_prefix(1);
     }
-    if (*fen == 'Q') {
+    if (!fen.empty() && fen[0] == 'Q') {
         mCastlingRights.AllowCastlingQueenside<Color::White>();
-        ++fen;
+        fen.remove_prefix(1);
     }
-    if (*fen == 'k') {
+    if (!fen.empty() && fen[0] == 'k') {
         mCastlingRights.AllowCastlingKingside<Color::Black>();
-        ++fen;
+        fen.remove_prefix(1);
     }
-    if (*fen == 'q') {
+    if (!fen.empty() && fen[0] == 'q') {
         mCastlingRights.AllowCastlingQueenside<Color::Black>();
-        ++fen;
+        fen.remove_prefix(1);
     }
-    if (mCastlingRights == CastlingRights::NONE) throw std::invalid_argument("Illegal fen: invalid castling rights");
+    if (mCastlingRights == CastlingRights::NONE) return false;
     mZobristHash.SwitchCastlingRights(mCastlingRights);
-    return fen;
+    return true;
 }
 
-const char *Position::InitFromFEN_EnPassant(const char *fen) {
-    if (*fen == '-') {
+bool Position::ParseFEN_EnPassant(std::string_view& fen) {
+    if (!fen.empty() && fen[0] == '-') {
         mEnPassant = Square::None;
-        return fen + 1;
+        fen.remove_prefix(1);
+        return true;
     }
 
-    if (*fen < 'a' || 'h' < *fen) throw std::invalid_argument("Illegal fen: invalid en passant");
-    BoardFile file = ToBoardFile(*fen - 'a');
-    ++fen;
+    if (fen.size() < 2) return false;
+    if (fen[0] < 'a' || 'h' < fen[0]) return false;
+    if (fen[1] < '1' || '8' < fen[1]) return false;
+    SetEnPassant(MakeSquare(ToBoardFile(fen[0] - 'a'), ToBoardRank(fen[1] - '1')));
+    fen.remove_prefix(2);
+    return true;
+}
 
-    if (*fen < '1' || '8' < *fen) throw std::invalid_argument("Illegal fen: invalid en passant");
-    BoardRank rank = ToBoardRank(*fen - '1');
-    mEnPassant = MakeSquare(file, rank);
-    mZobristHash.SwitchEnPassantFile(file);
-    return fen + 1;
+bool Position::ParseFEN_Number(std::string_view& fen, uint32_t& number) {
+    auto [end, error] = std::from_chars(fen.data(), fen.data() + fen.size(), number);
+    if (error != std::errc()) return false;
+    fen.remove_prefix(end - fen.data());
+    return true;
 }
 
-const char* Position::InitFromFEN_ReversableHalfMoves(const char* fen) {
-    mReversableHalfMovesCnt = std::stoul(fen);
-    while (*fen && *fen != ' ') ++fen;
-    return fen;
+bool Position::ParseFEN_ExpectSpace(std::string_view& fen) {
+    if (fen.empty() || fen[0] != ' ') return false;
+    fen.remove_prefix(1);
+    return true;
 }
 
-const char* Position::InitFromFEN_MoveNum(const char* fen) {
-    mMoveNum = std::stoul(fen);
-    while (*fen && *fen != ' ') ++fen;
-    return fen;
+bool Position::CastlingRightsValid() const {
+    auto inPlace = [this](Color color, BoardFile rookFile) {
+        BoardRank rank = color == Color::White ? BoardRank::R1 : BoardRank::R8;
+        return
+            GetBoard(MakeSquare(BoardFile::E, rank)) == MakePiece(color, PieceType::King) &&
+            GetBoard(MakeSquare(rookFile, rank)) == MakePiece(color, PieceType::Rook);
+    };
+    return
+        (!mCastlingRights.CanCastleKingside<Color::White>() || inPlace(Color::White, BoardFile::H)) &&
+        (!mCastlingRights.CanCastleQueenside<Color::White>() || inPlace(Color::White, BoardFile::A)) &&
+        (!mCastlingRights.CanCastleKingside<Color::Black>() || inPlace(Color::Black, BoardFile::H)) &&
+        (!mCastlingRights.CanCastleQueenside<Color::Black>() || inPlace(Color::Black, BoardFile::A));
 }
 
-const char* Position::InitFromFEN_ExpectSpace(const char* fen) {
-    if (*fen != ' ') throw std::invalid_argument("Illegal fen: fen ends before castling rights color");
-    return fen + 1;
+bool Position::EnPassantValid() const {
+    if (mEnPassant == Square::None) return true;
+    // Forward for the side to move, backward for the pawn that was pushed
+    Direction forward = mSideToMove == Color::White ? Direction::Up : Direction::Down;
+    BoardRank rank = mSideToMove == Color::White ? BoardRank::R6 : BoardRank::R3;
+    return
+        RankOf(mEnPassant) == rank &&
+        GetBoard(mEnPassant) == Piece::None &&
+        GetBoard(mEnPassant + forward) == Piece::None &&
+        GetBoard(mEnPassant - forward) == MakePiece(~mSideToMove, PieceType::Pawn);
 }
 
 void Position::AddPiece(Piece piece, Square square) {
@@ -433,14 +818,37 @@ void Position::UpdateAttacks() {
     Bitboard occupancy = GetOccupancy();
     Bitboard attacks = BB::NONE;
     attacks |= BigPieceAttacks<PieceType::King>(GetPiecesBB(color, PieceType::King), occupancy);
+#ifdef KOGGE_STONE_ATTACKS
+    Bitboard queens = GetPiecesBB(color, PieceType::Queen);
+    attacks |= BB::SliderAttacks(GetPiecesBB(color, PieceType::Rook) | queens, GetPiecesBB(color, PieceType::Bishop) | queens, occupancy);
+#else
     attacks |= BigPieceAttacks<PieceType::Queen>(GetPiecesBB(color, PieceType::Queen), occupancy);
     attacks |= BigPieceAttacks<PieceType::Rook>(GetPiecesBB(color, PieceType::Rook), occupancy);
     attacks |= BigPieceAttacks<PieceType::Bishop>(GetPiecesBB(color, PieceType::Bishop), occupancy);
+#endif
     attacks |= BigPieceAttacks<PieceType::Knight>(GetPiecesBB(color, PieceType::Knight), occupancy);
     attacks |= BB::PawnAttacks<color>(GetPiecesBB(color, PieceType::Pawn));
     Attacks(color) = attacks;
 }
 
+// Pieces among blockers that are the only piece between the king and one of the given sliders
+// Rays from the king only stop at pieces in rayOccupancy
+static Bitboard SingleBlockers(Square kingSquare, Bitboard straightSliders, Bitboard diagonalSliders, 
+                               Bitboard rayOccupancy, Bitboard blockers) {
+    Bitboard straightAttack = BB::Attacks<PieceType::Rook>(kingSquare, rayOccupancy);
+    Bitboard diagonalAttack = BB::Attacks<PieceType::Bishop>(kingSquare, rayOccupancy);
+
+    Bitboard slideAttackersBB   = (straightAttack & straightSliders) | (diagonalAttack & diagonalSliders);
+    Bitboard singleBlockersBB   = BB::NONE;
+    while (slideAttackersBB) {
+        Square attackerSq       = BB::PopLsb(slideAttackersBB);
+        Bitboard between        = BB::Between(kingSquare, attackerSq);
+        Bitboard blockedByBB    = between & blockers;
+        if (blockedByBB && !BB::AtLeast2(blockedByBB)) singleBlockersBB |= blockedByBB;
+    }
+    return singleBlockersBB;
+}
+
 template <Color color>
 void Position::UpdatePins() {
     constexpr Color other = ~color;
@@ -450,23 +858,35 @@ void Position::UpdatePins() {
     Bitboard straightSlidersBB = queensBB | rooksBB;
     Bitboard diagonalSlidersBB = queensBB | bishopsBB;
 
-    Square kingSquare = GetKingPosition(color);
-    Bitboard occupancyOther = GetOccupancy(other);
-    Bitboard straightAttack = BB::Attacks<PieceType::Rook>(kingSquare, occupancyOther);
-    Bitboard diagonalAttack = BB::Attacks<PieceType::Bishop>(kingSquare, occupancyOther);
-    
-    Bitboard straightAttackersBB = straightAttack & straightSlidersBB;
-    Bitboard diagonalAttackersBB = diagonalAttack & diagonalSlidersBB;
+    Pinned(color) = SingleBlockers(
+        GetKingPosition(color), straightSlidersBB, diagonalSlidersBB, GetOccupancy(other), GetOccupancy(color)
+    );
+}
 
-    Bitboard slideAttackersBB   = straightAttackersBB | diagonalAttackersBB;
-    Bitboard pinnedBB           = BB::NONE;
-    while (slideAttackersBB) {
-        Square attackerSq       = BB::PopLsb(slideAttackersBB);
-        Bitboard between        = BB::Between(kingSquare, attackerSq);
-        Bitboard blockedByBB    = between & GetOccupancy(color);
-        if (blockedByBB && !BB::AtLeast2(blockedByBB)) pinnedBB |= blockedByBB;
-    }
-    Pinned(color) = pinnedBB;
+template <Color color>
+void Position::UpdateCheckInfo() {
+    constexpr Color other = ~color;
+    Square theirKing    = GetKingPosition(other);
+    Bitboard occupancy  = GetOccupancy();
+    Bitboard straight   = BB::Attacks<PieceType::Rook>(theirKing, occupancy);
+    Bitboard diagonal   = BB::Attacks<PieceType::Bishop>(theirKing, occupancy);
+
+    mCheckingSquares[ToInt(PieceType::Knight)]  = BB::Attacks<PieceType::Knight>(theirKing);
+    mCheckingSquares[ToInt(PieceType::Bishop)]  = diagonal;
+    mCheckingSquares[ToInt(PieceType::Rook)]    = straight;
+    mCheckingSquares[ToInt(PieceType::Queen)]   = straight | diagonal;
+    mCheckingSquares[ToInt(PieceType::King)]    = BB::NONE;
+    mCheckingSquares[ToInt(PieceType::Pawn)]    = BB::PawnAttacks<other>(theirKing);
+
+    Bitboard queensBB   = GetPiecesBB(color, PieceType::Queen);
+    Bitboard rooksBB    = GetPiecesBB(color, PieceType::Rook);
+    Bitboard bishopsBB  = GetPiecesBB(color, PieceType::Bishop);
+    Bitboard straightSlidersBB = queensBB | rooksBB;
+    Bitboard diagonalSlidersBB = queensBB | bishopsBB;
+
+    mDiscoveredCheckCandidates = SingleBlockers(
+        theirKing, straightSlidersBB, diagonalSlidersBB, GetOccupancy(other), GetOccupancy(color)
+    );
 }
 
 void Position::UpdateKingAttackers() {
@@ -501,14 +921,22 @@ void Position::UpdateKingAttackers() {
     }
 }
 
+template <Color sideToMove>
 void Position::UpdateAuxiliaryInfo() {
+    PROFILE_SCOPE(UpdateAuxiliaryInfo);
     UpdateAttacks<Color::White>();
     UpdateAttacks<Color::Black>();
     UpdatePins<Color::White>();
     UpdatePins<Color::Black>();
+    UpdateCheckInfo<sideToMove>();
     UpdateKingAttackers();
 }
 
+void Position::UpdateAuxiliaryInfo() {
+    if (mSideToMove == Color::White)    UpdateAuxiliaryInfo<Color::White>();
+    else                                UpdateAuxiliaryInfo<Color::Black>();
+}
+
 bool Position::ZobristHashCorrect() const {
     ZobristHash hash;
     for (Square square = Square::A1; square <= Square::H8; ++square) {
@@ -5,18 +5,61 @@
 #include "castling_rights.hpp"
 #include "move.hpp"
 #include "zobrist_hash.hpp"
+#include "packed_position.hpp"
 
 #include <string>
+#include <string_view>
+
+// Result of parsing a FEN or EPD record
+enum class FenStatus : uint8_t {
+    Ok,
+    InvalidPiecePlacement,
+    InvalidSideToMove,
+    InvalidCastlingRights,
+    InvalidEnPassant,
+    InvalidHalfMoveClock,
+    InvalidMoveNumber,
+    InvalidKings,
+    InvalidOperation,
+    UnterminatedString,
+    TooManyOperands
+};
+
+const char* ToString(FenStatus status);
 
 class Position {
 public:
+    // Moves that can be played (and undone) from the initial position
+    static constexpr int MAX_HALF_MOVES = 4096;
+
     Position() { InitFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"); }
     explicit Position(const char* fen) { InitFromFEN(fen); }
     explicit Position(const std::string& fen) { InitFromFEN(fen.c_str()); }
+    // Throws std::invalid_argument on malformed data, as the FEN constructors do
+    explicit Position(const PackedPosition& packed);
+
+    // Replaces the position and clears the move history; returns false on malformed data, with the same
+    // checks as ParseFEN. After a failure the position is partly built and has to be initialized again.
+    bool InitFromPacked(const PackedPosition& packed);
+    // Replaces the position and clears the move history without throwing or allocating
+    // The move counters are optional, as in EPD. Advances fen past the parsed fields.
+    // After an error the position is partly built and has to be initialized again.
+    FenStatus ParseFEN(std::string_view& fen);
 
     void DoMove(Move move);
     void UndoMove();
 
+    // Whether the move could be played on this board, ignoring the safety of the own king
+    bool IsPseudoLegal(Move move) const;
+    // Whether a pseudo legal move leaves the own king safe
+    bool IsLegal(Move move) const;
+    // Whether a legal move checks the opposing king
+    bool GivesCheck(Move move) const;
+    // Whether the position occurred before since the last irreversible move (within the move history)
+    bool IsRepetition() const;
+    // Whether neither side can mate: no pawns, rooks or queens and at most one minor piece
+    bool IsInsufficientMaterial() const;
+
     Bitboard GetPiecesBB(Color color, PieceType type) const { return mPiecesBB[ToInt(color)][ToInt(type)]; }
     Bitboard GetPiecesBB(Piece piece) const                 { return GetPiecesBB(ColorOf(piece), PieceTypeOf(piece)); }
     Piece GetBoard(Square square) const                     { return mBoard[ToInt(square)]; }
@@ -34,6 +77,10 @@ public:
     Bitboard GetPinned(Color color) const       { return mPinned[ToInt(color)]; }
     Bitboard GetKingAttackers() const           { return mKingAttackers; }
     Bitboard GetCheckSquares() const            { return mCheckSquares; }
+    // Squares from which a piece of the given type of the side to move would check the opposing king
+    Bitboard GetCheckingSquares(PieceType type) const   { return mCheckingSquares[ToInt(type)]; }
+    // Pieces of the side to move whose departure may uncover a check by an own slider
+    Bitboard GetDiscoveredCheckCandidates() const       { return mDiscoveredCheckCandidates; }
 
     ZobristHash GetZobristHash() const          { return mZobristHash; }
 
@@ -41,10 +88,9 @@ public:
     bool IsDoubleCheck() const                  { return BB::AtLeast2(mKingAttackers); }
 
     std::string GetFEN() const;
+    PackedPosition GetPacked() const;
 
 private:
-    static constexpr int MAX_HALF_MOVES = 4096;
-
     struct RestoreInfo {
         Move move;
         Piece capturedPiece;
@@ -55,9 +101,26 @@ private:
         Array<Bitboard, COLOR_NUM> pinned;
         Bitboard kingAttackers;
         Bitboard checkSquares;
+        Array<Bitboard, PIECE_TYPE_NUM> checkingSquares;
+        Bitboard discoveredCheckCandidates;
         ZobristHash zobristHash;
     };
 
+    // What DoMove and UndoMove are specialized on besides the color of the moving side
+    enum class MoveKind : uint8_t {
+        Quiet,
+        DoublePawnPush,
+        Capture,
+        EnPassant,
+        KingsideCastle,
+        QueensideCastle,
+        Promotion,
+        PromotionCapture
+    };
+
+    // By the flags of the move encoding
+    static const Array<MoveKind, Move::FLAGS_NUM> MOVE_KINDS;
+
     Array2D<Bitboard, COLOR_NUM, PIECE_TYPE_NUM> mPiecesBB;
     Array<Piece, SQUARE_NUM> mBoard;
     Color mSideToMove                               = Color::White;
@@ -71,6 +134,8 @@ private:
     Array<Bitboard, COLOR_NUM> mPinned;
     Bitboard mKingAttackers                         = BB::NONE;
     Bitboard mCheckSquares                          = BB::NONE;
+    Array<Bitboard, PIECE_TYPE_NUM> mCheckingSquares;
+    Bitboard mDiscoveredCheckCandidates             = BB::NONE;
 
     ZobristHash mZobristHash;
 
@@ -84,14 +149,18 @@ private:
     Bitboard& Attacks(Color color)                  { return mAttacks[ToInt(color)]; }
     Bitboard& Pinned(Color color)                   { return mPinned[ToInt(color)]; }
 
+    void Clear();
     void InitFromFEN(const char* fen);
-    const char* InitFromFEN_PiecePosition(const char* fen);
-    const char* InitFromFEN_SideToMove(const char* fen);
-    const char* InitFromFEN_CastlingRights(const char* fen);
-    const char* InitFromFEN_EnPassant(const char* fen);
-    const char* InitFromFEN_ReversableHalfMoves(const char* fen);
-    const char* InitFromFEN_MoveNum(const char* fen);
-    const char* InitFromFEN_ExpectSpace(const char* fen);
+    bool ParseFEN_PiecePosition(std::string_view& fen);
+    bool ParseFEN_SideToMove(std::string_view& fen);
+    bool ParseFEN_CastlingRights(std::string_view& fen);
+    bool ParseFEN_EnPassant(std::string_view& fen);
+    bool ParseFEN_Number(std::string_view& fen, uint32_t& number);
+    bool ParseFEN_ExpectSpace(std::string_view& fen);
+    // Whether the king and rook of each castling right stand on their initial squares
+    bool CastlingRightsValid() const;
+    // Whether the en passant square was passed by a double push of the side that just moved
+    bool EnPassantValid() const;
     
     void AddPiece(Piece piece, Square square);
     void RemovePiece(Square square);
@@ -102,14 +171,36 @@ private:
     void SetEnPassant(Square square);
     void SwitchSideToMove();
 
+    // Dispatch on the kind of the move
+    template <Color color>
+    void DoMove(Move move);
+    template <Color color>
+    void UndoMove(const RestoreInfo& restoreInfo);
+
+    template <Color color, MoveKind kind>
+    void DoMove(Move move);
+    template <Color color, MoveKind kind>
+    void UndoMove(const RestoreInfo& restoreInfo);
+
     template <Color color>
     void UpdateCastlingRights(Square from, Square to);
 
+    template <Color color>
+    bool IsPseudoLegal(Move move) const;
+    template <Color color>
+    bool IsLegal(Move move) const;
+    template <Color color>
+    bool GivesCheck(Move move) const;
+
     template <Color color>
     void UpdateAttacks();
     template <Color color>
     void UpdatePins();
+    template <Color color>
+    void UpdateCheckInfo();
     void UpdateKingAttackers();
+    template <Color sideToMove>
+    void UpdateAuxiliaryInfo();
     void UpdateAuxiliaryInfo();
 
     bool ZobristHashCorrect() const;
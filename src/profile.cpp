@@ -0,0 +1,85 @@
+#include "profile.hpp"
+
+#ifdef PROFILE_COUNTERS
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+namespace Profile {
+    namespace {
+        constexpr Array<const char*, ZONE_NUM> ZONE_NAMES = {
+            "DoMove", "UndoMove", "UpdateAuxiliaryInfo", "GenerateMoves", "Evaluate", "TableProbe", "TableStore"
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<ThreadCounters*> running;
+            Counters finished;
+        };
+
+        Registry& GetRegistry() {
+            static Registry registry;
+            return registry;
+        }
+
+        void Add(Counters& to, const Counters& from) {
+            for (int i = 0; i < ZONE_NUM; ++i) {
+                to.calls[i]         += from.calls[i];
+                to.cycles[i]        += from.cycles[i];
+                to.selfCycles[i]    += from.selfCycles[i];
+            }
+        }
+    }
+
+    ThreadCounters::ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        registry.running.push_back(this);
+    }
+
+    ThreadCounters::~ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        Add(registry.finished, *this);
+        registry.running.erase(std::find(registry.running.begin(), registry.running.end(), this));
+    }
+
+    void Dump(std::ostream& out) {
+        Registry& registry = GetRegistry();
+        Counters total;
+        {
+            std::lock_guard lock(registry.mutex);
+            total = registry.finished;
+            for (const ThreadCounters* counters : registry.running) Add(total, *counters);
+        }
+
+        Array<int, ZONE_NUM> order;
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return total.selfCycles[a] > total.selfCycles[b]; });
+        uint64_t selfSum = std::max<uint64_t>(std::accumulate(total.selfCycles.begin(), total.selfCycles.end(), uint64_t(0)), 1);
+
+        out << "Zone                       calls      Mcycles  cycles/call  self Mcycles  self %\n";
+        for (int i : order) {
+            out << std::left << std::setw(20) << ZONE_NAMES[i] << std::right << std::fixed
+                << std::setw(12) << total.calls[i]
+                << std::setw(13) << std::setprecision(1) << total.cycles[i] / 1e6
+                << std::setw(13) << std::setprecision(1) << double(total.cycles[i]) / std::max<uint64_t>(total.calls[i], 1)
+                << std::setw(14) << std::setprecision(1) << total.selfCycles[i] / 1e6
+                << std::setw(8) << std::setprecision(1) << 100.0 * total.selfCycles[i] / selfSum << '\n';
+        }
+        out.flush();
+    }
+
+    void Reset() {
+        Registry& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        registry.finished = {};
+        for (ThreadCounters* counters : registry.running) static_cast<Counters&>(*counters) = {};
+    }
+}
+
+#endif
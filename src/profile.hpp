@@ -0,0 +1,102 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+
+#ifdef PROFILE_COUNTERS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+/**
+ * Call counts and cycle counts (RDTSC) of the hot functions, compiled in only with PROFILE_COUNTERS
+ * Sampling profilers attribute the time of these small, inlined functions poorly; the scoped timers
+ * give exact numbers at the cost of two RDTSC per call. Without PROFILE_COUNTERS they are empty.
+ * The counters are per thread, so the timers do not contend; Dump adds them up over all threads.
+ */
+namespace Profile {
+    enum class Zone : uint8_t {
+        DoMove,
+        UndoMove,
+        UpdateAuxiliaryInfo,
+        GenerateMoves,
+        Evaluate,
+        TableProbe,
+        TableStore
+    };
+    constexpr int ZONE_NUM = 7;
+
+    constexpr int ToInt(Zone zone) { return static_cast<int>(zone); }
+
+#ifdef PROFILE_COUNTERS
+    // Flat profile of the counters of all threads; only meaningful while the measured threads are idle
+    void Dump(std::ostream& out);
+    void Reset();
+
+    struct Counters {
+        Array<uint64_t, ZONE_NUM> calls = {};
+        Array<uint64_t, ZONE_NUM> cycles = {};
+        Array<uint64_t, ZONE_NUM> selfCycles = {};      // Without the cycles of the zones entered from this one
+    };
+
+    // Registered while its thread runs; added to the totals of finished threads on exit
+    class ThreadCounters : public Counters {
+    public:
+        ThreadCounters();
+        ~ThreadCounters();
+    };
+
+    inline thread_local ThreadCounters tCounters;
+
+    inline uint64_t ReadCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Zone zone) : mZone(zone), mParent(sCurrent) {
+            sCurrent = this;
+            mStart = ReadCycles();
+        }
+
+        ~ScopedTimer() {
+            uint64_t cycles = ReadCycles() - mStart;
+            Counters& counters = tCounters;
+            ++counters.calls[ToInt(mZone)];
+            counters.cycles[ToInt(mZone)] += cycles;
+            counters.selfCycles[ToInt(mZone)] += cycles - mChildCycles;
+            if (mParent) mParent->mChildCycles += cycles;
+            sCurrent = mParent;
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        static inline thread_local ScopedTimer* sCurrent = nullptr;
+
+        Zone mZone;
+        ScopedTimer* mParent;
+        uint64_t mStart;
+        uint64_t mChildCycles = 0;
+    };
+#else
+    inline void Dump(std::ostream&) {}
+    inline void Reset() {}
+#endif
+}
+
+#ifdef PROFILE_COUNTERS
+#define PROFILE_SCOPE(zone) Profile::ScopedTimer profileTimer(Profile::Zone::zone)
+#else
+#define PROFILE_SCOPE(zone)
+#endif
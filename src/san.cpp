@@ -0,0 +1,157 @@
+#include "san.hpp"
+#include "move_list.hpp"
+
+#include <cstdlib>
+
+namespace {
+    // Indexed by PieceType
+    constexpr std::string_view PIECE_LETTERS = "NBRQK";
+
+    bool IsLegalMove(const Position& pos, Move move) {
+        return pos.IsPseudoLegal(move) && pos.IsLegal(move);
+    }
+
+    // The move of the piece on from to to with the flags the board implies; not necessarily legal
+    Move NewMove(const Position& pos, Square from, Square to, bool promotion, PieceType promotionType) {
+        bool capture = pos.GetBoard(to) != Piece::None;
+        if (promotion) {
+            return capture ? Move::NewPromotionCapture(from, to, promotionType) : Move::NewPromotionNormal(from, to, promotionType);
+        }
+        if (PieceTypeOf(pos.GetBoard(from)) == PieceType::Pawn) {
+            if (to == pos.GetEnPassant() && FileOf(from) != FileOf(to)) return Move::NewEnPassant(from, to);
+            if (std::abs(ToInt(RankOf(to)) - ToInt(RankOf(from))) == 2) return Move::NewDoublePawnPush(from, to);
+        }
+        return capture ? Move::NewCapture(from, to) : Move::NewQuiet(from, to);
+    }
+
+    Move ParseCastle(const Position& pos, bool kingside) {
+        Color us = pos.GetSideToMove();
+        Square king = pos.GetKingPosition(us);
+        if (king != MakeSquare(BoardFile::E, us == Color::White ? BoardRank::R1 : BoardRank::R8)) return Move::NewNone();
+        Move move = kingside
+            ? Move::NewKingsideCastle(king, king + Direction::Right + Direction::Right)
+            : Move::NewQueensideCastle(king, king + Direction::Left + Direction::Left);
+        return IsLegalMove(pos, move) ? move : Move::NewNone();
+    }
+
+    bool ParseSquare(char file, char rank, Square& square) {
+        if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return false;
+        square = MakeSquare(ToBoardFile(file - 'a'), ToBoardRank(rank - '1'));
+        return true;
+    }
+
+    void AppendSquare(std::string& san, Square square) {
+        san += char('a' + ToInt(FileOf(square)));
+        san += char('1' + ToInt(RankOf(square)));
+    }
+}
+
+Move ParseSAN(const Position& pos, std::string_view san) {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) san.remove_suffix(1);
+    if (san == "O-O" || san == "0-0")       return ParseCastle(pos, true);
+    if (san == "O-O-O" || san == "0-0-0")   return ParseCastle(pos, false);
+    if (san.size() < 2) return Move::NewNone();
+
+    PieceType type = PieceType::Pawn;
+    if (size_t letter = PIECE_LETTERS.find(san[0]); letter != std::string_view::npos) {
+        type = ToPieceType(letter);
+        san.remove_prefix(1);
+    }
+
+    // The promotion piece follows the target square, so a lowercase b cannot be a file here
+    bool promotion = false;
+    PieceType promotionType = PieceType::Queen;
+    if (type == PieceType::Pawn && san.size() >= 3) {
+        char last = san.back() >= 'a' ? char(san.back() - 'a' + 'A') : san.back();
+        if (size_t letter = PIECE_LETTERS.substr(0, 4).find(last); letter != std::string_view::npos) {
+            promotion = true;
+            promotionType = ToPieceType(letter);
+            san.remove_suffix(1);
+            if (san.back() == '=') san.remove_suffix(1);
+        }
+    }
+
+    Square to;
+    if (san.size() < 2 || !ParseSquare(san[san.size() - 2], san.back(), to)) return Move::NewNone();
+    san.remove_suffix(2);
+    if (!san.empty() && (san.back() == 'x' || san.back() == ':')) san.remove_suffix(1);
+
+    // Disambiguation by file, rank or both
+    if (san.size() > 2) return Move::NewNone();
+    Bitboard fromMask = BB::ALL;
+    for (char c : san) {
+        if (c >= 'a' && c <= 'h')       fromMask &= BB::FileBB(ToBoardFile(c - 'a'));
+        else if (c >= '1' && c <= '8')  fromMask &= BB::RankBB(ToBoardRank(c - '1'));
+        else                            return Move::NewNone();
+    }
+
+    Color us = pos.GetSideToMove();
+    Bitboard candidates = pos.GetPiecesBB(us, type) & fromMask;
+    if (type == PieceType::Pawn) {
+        // Without a file a pawn move is a push, with one it is a capture from that file
+        Bitboard toFileBB = BB::FileBB(FileOf(to));
+        if (san.empty()) candidates &= toFileBB;
+        candidates &= toFileBB | BB::PawnAttacks(~us, to);
+    }
+    else {
+        candidates &= BB::Attacks(type, to, pos.GetOccupancy());
+    }
+
+    Move found = Move::NewNone();
+    while (candidates) {
+        Move move = NewMove(pos, BB::PopLsb(candidates), to, promotion, promotionType);
+        if (!IsLegalMove(pos, move)) continue;
+        if (found != Move::NewNone()) return Move::NewNone();   // Ambiguous
+        found = move;
+    }
+    return found;
+}
+
+std::string ToSAN(Position& pos, Move move) {
+    Square from = move.GetFrom();
+    Square to = move.GetTo();
+    PieceType type = PieceTypeOf(pos.GetBoard(from));
+
+    std::string san;
+    if (move.IsCastle()) {
+        san = move.IsKingsideCastle() ? "O-O" : "O-O-O";
+    }
+    else if (type == PieceType::Pawn) {
+        if (move.IsCapture()) {
+            san += char('a' + ToInt(FileOf(from)));
+            san += 'x';
+        }
+        AppendSquare(san, to);
+        if (move.IsPromotion()) {
+            san += '=';
+            san += PIECE_LETTERS[ToInt(move.GetPromotionType())];
+        }
+    }
+    else {
+        san += PIECE_LETTERS[ToInt(type)];
+
+        // Other pieces of the same type that could legally go to the same square
+        Color us = pos.GetSideToMove();
+        Bitboard others = BB::Attacks(type, to, pos.GetOccupancy()) & pos.GetPiecesBB(us, type) & ~BB::SquareBB(from);
+        Bitboard rivals = BB::NONE;
+        while (others) {
+            Square other = BB::PopLsb(others);
+            if (IsLegalMove(pos, NewMove(pos, other, to, false, type))) rivals |= BB::SquareBB(other);
+        }
+        if (rivals) {
+            if (!(rivals & BB::FileBB(FileOf(from))))       san += char('a' + ToInt(FileOf(from)));
+            else if (!(rivals & BB::RankBB(RankOf(from))))  san += char('1' + ToInt(RankOf(from)));
+            else                                            AppendSquare(san, from);
+        }
+
+        if (move.IsCapture()) san += 'x';
+        AppendSquare(san, to);
+    }
+
+    if (pos.GivesCheck(move)) {
+        pos.DoMove(move);
+        san += MoveList(pos).size() == 0 ? '#' : '+';
+        pos.UndoMove();
+    }
+    return san;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "position.hpp"
+
+#include <string>
+#include <string_view>
+
+/**
+ * Standard algebraic notation, e.g. Nbd7, exd6, e8=Q+, O-O
+ * See https://www.chessprogramming.org/Algebraic_Chess_Notation
+ */
+
+// Matches a move in SAN against the legal moves; Move::NewNone() if it is illegal, ambiguous or malformed
+// Accepts the usual deviations: check and annotation suffixes (+ # ! ?), promotions without '=',
+// castling written with zeros, superfluous disambiguation
+// Finds the moving piece with an attack lookup from the target square instead of generating all moves
+Move ParseSAN(const Position& pos, std::string_view san);
+
+// SAN of a legal move with minimal disambiguation and check or mate suffix
+// Plays the move to detect mate; the position is restored before returning
+std::string ToSAN(Position& pos, Move move);
@@ -1,84 +1,269 @@
 #include "search.hpp"
 #include "evaluate.hpp"
 #include "move_list.hpp"
+#include "move_picker.hpp"
+#include "time_manager.hpp"
 
-static Score Quiescence(Position& pos, Score alpha, Score beta) {
-    Score bestScore = SCORE_MIN;
-    if (!pos.IsCheck()) {
-        // Stand pat
-        bestScore = Evaluate(pos);
-        if (bestScore >= beta) return bestScore;
-        if (bestScore > alpha) alpha = bestScore;
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+namespace {
+    // Nodes are published to the shared counter in batches, which is also how often the limits are checked
+    constexpr uint64_t NODES_BATCH = 1024;
+
+    struct SharedState {
+        TranspositionTable& table;
+        const SearchLimits& limits;
+        const std::atomic<bool>& stop;
+        TimeManager time;                       // Only used by the main thread
+        std::atomic<bool> abort = false;        // Set by the main thread once a limit is reached
+        std::atomic<uint64_t> nodes = 0;
+    };
+
+    // Mate scores are stored relative to the node instead of the root, so that they stay correct
+    // when the position is reached through a different number of plies
+    Score ScoreToTable(Score score, int ply) {
+        if (score >= SCORE_MATE_IN_MAX_PLY)     return score + ply;
+        if (score <= -SCORE_MATE_IN_MAX_PLY)    return score - ply;
+        return score;
     }
 
-    MoveList moves(pos);
-    for (Move move : moves) {
-        // TODO: Search for moves that check opponent
-        // TODO: Static exchange evaluation 
-        if (!pos.IsCheck() && !move.IsCapture()) continue;
-        pos.DoMove(move);
-        Score score = -Quiescence(pos, -beta, -alpha);
-        pos.UndoMove();
-
-        if (score >= beta) { // Fail high
-            return score;
+    Score ScoreFromTable(Score score, int ply) {
+        if (score >= SCORE_MATE_IN_MAX_PLY)     return score - ply;
+        if (score <= -SCORE_MATE_IN_MAX_PLY)    return score + ply;
+        return score;
+    }
+
+    class SearchThread {
+    public:
+        SearchThread(const Position& pos, SharedState& shared, bool isMain)
+            : mPos(pos), mShared(shared), mIsMain(isMain) {}
+
+        // Iterative deepening up to the depth limit or until the search is stopped
+        SearchResult Run(int firstDepth, const SearchCallback& onIteration);
+
+    private:
+        Position mPos;
+        SharedState& mShared;
+        bool mIsMain;
+        bool mStopped = false;
+        uint64_t mNodes = 0;
+
+        // Triangular PV table: the PV of the node at ply p is mPv[p][p..mPvLength[p])
+        Array2D<Move, MAX_PLY, MAX_PLY> mPv;
+        Array<int, MAX_PLY> mPvLength;
+
+        Score Negamax(int depth, int ply, Score alpha, Score beta);
+        Score Quiescence(int ply, Score alpha, Score beta);
+
+        bool CountNodeAndCheckStop();
+        bool LimitReached() const;
+        void UpdatePv(int ply, Move move);
+        void ExtendPvFromTable(std::vector<Move>& pv, int maxLength);
+        void FlushNodes();
+    };
+
+    bool SearchThread::CountNodeAndCheckStop() {
+        if (++mNodes % NODES_BATCH == 0) {
+            mShared.nodes.fetch_add(NODES_BATCH, std::memory_order_relaxed);
+            if (mIsMain && LimitReached()) mShared.abort.store(true, std::memory_order_relaxed);
         }
-        if (score > bestScore) {
-            bestScore = score;
-            if (score > alpha) {
-                alpha = score;
+        // Polled on every node: a stop from the input thread is seen within microseconds
+        mStopped = mShared.stop.load(std::memory_order_relaxed) || mShared.abort.load(std::memory_order_relaxed);
+        return mStopped;
+    }
+
+    bool SearchThread::LimitReached() const {
+        const SearchLimits& limits = mShared.limits;
+        if (limits.nodes && mShared.nodes.load(std::memory_order_relaxed) >= limits.nodes) return true;
+        return mShared.time.HardLimitReached();
+    }
+
+    void SearchThread::FlushNodes() {
+        mShared.nodes.fetch_add(mNodes % NODES_BATCH, std::memory_order_relaxed);
+        mNodes -= mNodes % NODES_BATCH;
+    }
+
+    void SearchThread::UpdatePv(int ply, Move move) {
+        mPv[ply][ply] = move;
+        for (int i = ply + 1; i < mPvLength[ply + 1]; ++i) mPv[ply][i] = mPv[ply + 1][i];
+        mPvLength[ply] = std::max(mPvLength[ply + 1], ply + 1);
+    }
+
+    // A cutoff on a table entry ends the PV early; the hash moves usually continue it
+    void SearchThread::ExtendPvFromTable(std::vector<Move>& pv, int maxLength) {
+        for (Move move : pv) mPos.DoMove(move);
+        int played = int(pv.size());
+        while (int(pv.size()) < maxLength && !mPos.IsRepetition()) {
+            TranspositionTable::Entry entry = mShared.table.GetEntry(mPos.GetZobristHash());
+            if (!entry.IsValid()) break;
+            Move move = entry.GetBestMove();
+            if (move == Move::NewNone() || !mPos.IsPseudoLegal(move) || !mPos.IsLegal(move)) break;
+            pv.push_back(move);
+            mPos.DoMove(move);
+            ++played;
+        }
+        while (played--) mPos.UndoMove();
+    }
+
+    Score SearchThread::Quiescence(int ply, Score alpha, Score beta) {
+        mPvLength[ply] = ply;
+        if (CountNodeAndCheckStop()) return 0;
+        if (ply >= MAX_PLY - 1) return Evaluate(mPos);
+
+        Score bestScore = SCORE_MIN;
+        if (!mPos.IsCheck()) {
+            // Stand pat
+            bestScore = Evaluate(mPos);
+            if (bestScore >= beta) return bestScore;
+            if (bestScore > alpha) alpha = bestScore;
+        }
+
+        // Captures only, or all evasions while in check
+        MovePicker picker(mPos);
+        for (Move move = picker.Next(); move != Move::NewNone(); move = picker.Next()) {
+            // TODO: Search for moves that check opponent
+            // TODO: Static exchange evaluation
+            mPos.DoMove(move);
+            Score score = -Quiescence(ply + 1, -beta, -alpha);
+            mPos.UndoMove();
+            if (mStopped) return 0;
+
+            if (score >= beta) { // Fail high
+                return score;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                if (score > alpha) {
+                    alpha = score;
+                }
             }
         }
+
+        // Checkmated: every evasion was generated and none exists
+        if (bestScore == SCORE_MIN) return MatedIn(ply);
+        return bestScore;
     }
 
-    return bestScore;
-}
+    Score SearchThread::Negamax(int depth, int ply, Score alpha, Score beta) {
+        if (depth <= 0) return Quiescence(ply, alpha, beta);
+
+        mPvLength[ply] = ply;
+        if (CountNodeAndCheckStop()) return 0;
+        if (ply > 0) {
+            if (mPos.GetReversableHalfMovesCnt() >= 100 || mPos.IsRepetition()) return 0;
+            if (ply >= MAX_PLY - 1) return Evaluate(mPos);
+        }
 
-static Score Negamax(Position& pos, TranspositionTable& table, int depth, Score alpha, Score beta) {
-    if (depth <= 0) return Quiescence(pos, alpha, beta);
-    /*
-    Move bestMove = Move::NewNone();
-    TranspositionTable::Entry tableEntry = table.GetEntry(pos.GetZobristHash());
-    if (tableEntry.IsValid()) {
-        bestMove = tableEntry.GetBestMove();
-        Score score = tableEntry.GetScore();
-        if (tableEntry.GetType() == TranspositionTable::Entry::Type::PV) return score;
-        if (tableEntry.GetType() == TranspositionTable::Entry::Type::Fail_Low && score > alpha) alpha = score;
-        if (tableEntry.GetType() == TranspositionTable::Entry::Type::Fail_High && score < beta) beta = score;        
-        if (beta <= alpha)
-    } 
-    */
-    
-    MoveList moves(pos);
-    Score bestScore = SCORE_MIN;
-    Move bestMove = Move::NewNone();
-    for (Move move : moves) {
-        pos.DoMove(move);
-        Score score = -Negamax(pos, table, depth - 1, -beta, -alpha);
-        pos.UndoMove();
-        if (score >= beta) { // Fail high
-            table.SetEntry(TranspositionTable::Entry(
-                pos.GetZobristHash(), move, score, depth, TranspositionTable::Entry::Type::Fail_High
-            ));
-            return score;
+        // The hash move is tried before anything is generated: a cutoff makes the generation unnecessary
+        TranspositionTable& table = mShared.table;
+        TranspositionTable::Entry tableEntry = table.GetEntry(mPos.GetZobristHash());
+        Move hashMove = Move::NewNone();
+        if (tableEntry.IsValid()) {
+            hashMove = tableEntry.GetBestMove();
+            // No cutoff at the root, which has to produce a move and a PV
+            if (ply > 0 && tableEntry.GetDepth() >= depth) {
+                Score score = ScoreFromTable(tableEntry.GetScore(), ply);
+                TranspositionTable::Entry::Type type = tableEntry.GetType();
+                if (type == TranspositionTable::Entry::Type::PV
+                    || (type == TranspositionTable::Entry::Type::Fail_High && score >= beta)
+                    || (type == TranspositionTable::Entry::Type::Fail_Low && score <= alpha)) {
+                    return score;
+                }
+            }
         }
-        if (score > bestScore) {
-            bestScore = score;
-            if (score > alpha) {
-                alpha = score;
+
+        Score bestScore = SCORE_MIN;
+        Move bestMove = Move::NewNone();
+
+        MovePicker picker(mPos, hashMove);
+        for (Move move = picker.Next(); move != Move::NewNone(); move = picker.Next()) {
+            mPos.DoMove(move);
+            Score score = -Negamax(depth - 1, ply + 1, -beta, -alpha);
+            mPos.UndoMove();
+            if (mStopped) return 0;
+
+            if (score >= beta) { // Fail high
+                table.SetEntry(TranspositionTable::Entry(
+                    mPos.GetZobristHash(), move, ScoreToTable(score, ply), depth, TranspositionTable::Entry::Type::Fail_High
+                ));
+                return score;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                bestMove = move;
+                if (score > alpha) {
+                    alpha = score;
+                    UpdatePv(ply, move);
+                }
             }
         }
+
+        // No legal moves: checkmate or stalemate
+        if (bestMove == Move::NewNone()) return mPos.IsCheck() ? MatedIn(ply) : 0;
+
+        // Fail low?
+        TranspositionTable::Entry::Type entryType = alpha <= bestScore ? TranspositionTable::Entry::Type::PV : TranspositionTable::Entry::Type::Fail_Low;
+
+        table.SetEntry(TranspositionTable::Entry(
+            mPos.GetZobristHash(), bestMove, ScoreToTable(bestScore, ply), depth, entryType
+        ));
+        return bestScore;
     }
 
-    // Fail low?
-    TranspositionTable::Entry::Type entryType = alpha <= bestScore ? TranspositionTable::Entry::Type::PV : TranspositionTable::Entry::Type::Fail_Low;
+    SearchResult SearchThread::Run(int firstDepth, const SearchCallback& onIteration) {
+        SearchResult result;
+        for (int depth = firstDepth; depth <= mShared.limits.depth; ++depth) {
+            Score score = Negamax(depth, 0, SCORE_MIN, SCORE_MAX);
+            if (mStopped) break;
+
+            result.depth    = depth;
+            result.score    = score;
+            result.pv.assign(mPv[0].begin(), mPv[0].begin() + mPvLength[0]);
+            result.bestMove = result.pv.empty() ? Move::NewNone() : result.pv[0];
+            if (!mIsMain) continue;
 
-    table.SetEntry(TranspositionTable::Entry(
-        pos.GetZobristHash(), bestMove, bestScore, depth, entryType
-    ));
-    return bestScore;
+            ExtendPvFromTable(result.pv, depth);
+            result.nodes    = mShared.nodes.load(std::memory_order_relaxed) + mNodes % NODES_BATCH;
+            result.time     = mShared.time.Elapsed();
+            if (onIteration) onIteration(result);
+
+            if (mShared.time.IterationDone(result.bestMove, score)) break;
+            // A forced mate was found within the searched depth, deeper iterations cannot improve on it
+            if (IsMateScore(score) && !mShared.limits.infinite && SCORE_MATE - std::abs(score) <= depth) break;
+        }
+        FlushNodes();
+        return result;
+    }
 }
 
-void Search(Position& pos, TranspositionTable& table, int depth) {
-    Negamax(pos, table, depth, SCORE_MIN, SCORE_MAX);
+SearchResult Search(const Position& pos, TranspositionTable& table, const SearchLimits& limits,
+                    const std::atomic<bool>& stop, int threads, const SearchCallback& onIteration) {
+    SharedState shared{ table, limits, stop, TimeManager(limits, pos.GetSideToMove()) };
+    if (limits.newTableAge) table.NewSearch();
+
+    std::vector<std::unique_ptr<SearchThread>> helpers;
+    std::vector<std::thread> helperThreads;
+    for (int i = 1; i < threads; ++i) {
+        helpers.push_back(std::make_unique<SearchThread>(pos, shared, false));
+        // Odd helpers start one ply deeper so that the threads spread over different depths
+        helperThreads.emplace_back([&helper = *helpers.back(), i] { helper.Run(1 + i % 2, {}); });
+    }
+
+    auto mainThread = std::make_unique<SearchThread>(pos, shared, true);
+    SearchResult result = mainThread->Run(1, onIteration);
+
+    shared.abort.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : helperThreads) thread.join();
+
+    // Stopped before the first iteration completed: any legal move is better than none
+    if (result.bestMove == Move::NewNone()) {
+        MoveList moveList(pos);
+        if (moveList.size() > 0) result.bestMove = *moveList.begin();
+    }
+    result.nodes = shared.nodes.load(std::memory_order_relaxed);
+    result.time = shared.time.Elapsed();
+    return result;
 }
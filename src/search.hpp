@@ -3,4 +3,52 @@
 #include "position.hpp"
 #include "transposition_table.hpp"
 
-void Search(Position& pos, TranspositionTable& table, int depth);
\ No newline at end of file
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+constexpr int MAX_PLY = 128;
+
+constexpr Score SCORE_MATE_IN_MAX_PLY = SCORE_MATE - MAX_PLY;
+
+constexpr Score MateIn(int ply)     { return SCORE_MATE - ply; }
+constexpr Score MatedIn(int ply)    { return -SCORE_MATE + ply; }
+constexpr bool IsMateScore(Score score) { return score >= SCORE_MATE_IN_MAX_PLY || score <= -SCORE_MATE_IN_MAX_PLY; }
+// Moves to the mate of a mate score, negative when getting mated (as in UCI "score mate")
+constexpr int MateInMoves(Score score)  { return score > 0 ? (SCORE_MATE - score + 1) / 2 : -(SCORE_MATE + score) / 2; }
+
+// What ends a search; a value of 0 means no limit of that kind
+struct SearchLimits {
+    int depth = MAX_PLY - 1;
+    uint64_t nodes = 0;
+    int64_t moveTime = 0;                           // ms
+    Array<int64_t, COLOR_NUM> time = {};            // Remaining clock time in ms
+    Array<int64_t, COLOR_NUM> increment = {};       // ms
+    int movesToGo = 0;
+    bool infinite = false;                          // Only stops on the stop flag or at the maximal depth
+    // Whether the search starts a new age of the table; off when searches share a table whose age
+    // the caller advances itself, so that the entries of concurrent searches do not look stale
+    bool newTableAge = true;
+};
+
+struct SearchResult {
+    Move bestMove = Move::NewNone();
+    Score score = 0;
+    int depth = 0;                                  // Last completed iteration
+    uint64_t nodes = 0;                             // Over all threads
+    int64_t time = 0;                               // ms
+    std::vector<Move> pv;
+};
+
+// Called by the main search thread after each completed iteration
+using SearchCallback = std::function<void(const SearchResult&)>;
+
+/**
+ * Iterative deepening alpha-beta search
+ * With several threads the helpers search the same position with their own Position and share
+ * only the transposition table (Lazy SMP); the result is the one of the main thread.
+ * Stops as soon as stop is set by another thread, or when the limits are reached.
+ */
+SearchResult Search(const Position& pos, TranspositionTable& table, const SearchLimits& limits,
+                    const std::atomic<bool>& stop, int threads = 1, const SearchCallback& onIteration = {});
@@ -0,0 +1,48 @@
+#include "time_manager.hpp"
+
+#include <algorithm>
+
+namespace {
+    constexpr int DEFAULT_MOVES_TO_GO   = 30;
+    // Cap of the hard limit as a multiple of the optimal time
+    constexpr int64_t HARD_LIMIT_FACTOR = 3;
+    // Soft limit scale in percent by the number of iterations the best move stayed the same
+    constexpr Array<int64_t, 5> STABILITY_SCALE = { 160, 120, 100, 85, 70 };
+    // A score drop of up to SCORE_DROP_MAX gives up to SCORE_DROP_MAX / 3 percent more time
+    constexpr int SCORE_DROP_MAX        = 150;
+}
+
+TimeManager::TimeManager(const SearchLimits& limits, Color us) : mStart(Clock::now()), mSoftLimit(0), mHardLimit(0) {
+    if (limits.infinite) return;
+    // A fixed move time is used up, there is nothing to save for later moves
+    if (limits.moveTime) {
+        mHardLimit = limits.moveTime;
+        return;
+    }
+
+    int64_t time = limits.time[ToInt(us)];
+    if (time <= 0) return;
+    int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : DEFAULT_MOVES_TO_GO;
+    int64_t available = std::max<int64_t>(time - MOVE_OVERHEAD, 1);
+    // Never more than the share of the next few moves, all of it only for the last move before the time control
+    int64_t maximum = std::max<int64_t>(available / std::min(movesToGo, 4), 1);
+    int64_t optimum = std::min(available / movesToGo + limits.increment[ToInt(us)] * 3 / 4, maximum);
+
+    mHardLimit = std::clamp<int64_t>(optimum * HARD_LIMIT_FACTOR, 1, maximum);
+    // The next iteration takes about as long as all of the previous ones: at half of the optimal time
+    // the one that is started most likely ends around it
+    mSoftLimit = std::max<int64_t>(optimum / 2, 1);
+}
+
+bool TimeManager::IterationDone(Move bestMove, Score score) {
+    bool firstIteration = mBestMove == Move::NewNone();
+    mStableIterations = bestMove == mBestMove ? std::min<int>(mStableIterations + 1, STABILITY_SCALE.size() - 1) : 0;
+    int64_t scale = STABILITY_SCALE[mStableIterations];
+    int drop = firstIteration ? 0 : std::clamp(mScore - score, 0, SCORE_DROP_MAX);
+    scale = scale * (300 + drop) / 300;
+    mBestMove = bestMove;
+    mScore = score;
+
+    if (!mSoftLimit) return false;
+    return Elapsed() >= std::min(mSoftLimit * scale / 100, mHardLimit);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "search.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Time allocation of a search under a clock
+ * The hard limit is checked by the main thread every NODES_BATCH nodes and aborts the iteration; the
+ * soft limit is only checked between iterations. The soft limit is scaled after each iteration: a
+ * best move that keeps changing or a dropping score gets more time, a stable best move less.
+ */
+class TimeManager {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Margin kept on the clock for the communication with the GUI
+    static constexpr int64_t MOVE_OVERHEAD = 50;    // ms
+
+    TimeManager(const SearchLimits& limits, Color us);
+
+    int64_t Elapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - mStart).count();
+    }
+
+    int64_t GetSoftLimit() const    { return mSoftLimit; }
+    int64_t GetHardLimit() const    { return mHardLimit; }
+
+    bool HardLimitReached() const   { return mHardLimit && Elapsed() >= mHardLimit; }
+    // Called after each completed iteration of the main thread: whether not to start another one
+    bool IterationDone(Move bestMove, Score score);
+
+private:
+    Clock::time_point mStart;
+    int64_t mSoftLimit;                             // ms, 0 without a limit between iterations
+    int64_t mHardLimit;                             // ms, 0 without a time limit
+    Move mBestMove = Move::NewNone();
+    int mStableIterations = 0;                      // Completed iterations with the same best move
+    Score mScore = 0;                               // Of the previous iteration
+};
@@ -1,7 +1,25 @@
 #include "transposition_table.hpp"
 
-TranspositionTable::TranspositionTable(uint8_t log_2_size) {
-    mTable.resize(1 << log_2_size);
-    mask = (1 << log_2_size) - 1;
-    currentAge = 0;
-}
\ No newline at end of file
+#include <bit>
+#include <stdexcept>
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    Resize(megabytes);
+}
+
+void TranspositionTable::Resize(size_t megabytes) {
+    size_t slots = megabytes * 1024 * 1024 / sizeof(Slot);
+    if (slots == 0) throw std::invalid_argument("Transposition table size must be at least 1 MB");
+    slots = std::bit_floor(slots);
+    mTable = std::make_unique<Slot[]>(slots);
+    mMask = slots - 1;
+    mCurrentAge = 0;
+}
+
+void TranspositionTable::Clear() {
+    for (size_t i = 0; i <= mMask; ++i) {
+        mTable[i].hashXorData.store(0, std::memory_order_relaxed);
+        mTable[i].data.store(0, std::memory_order_relaxed);
+    }
+    mCurrentAge = 0;
+}
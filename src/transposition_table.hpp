@@ -2,11 +2,17 @@
 
 #include "zobrist_hash.hpp"
 #include "move.hpp"
+#include "profile.hpp"
 
-#include <vector>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
 // https://www.chessprogramming.org/Transposition_Table
+// Shared by all search threads without locks: a slot stores the hash XOR the packed entry next to
+// the entry, so a slot torn by concurrent writes fails the hash check (same scheme as PerftTable)
 class TranspositionTable {
 public:
     class Entry {
@@ -20,7 +26,7 @@ public:
         Entry() : mHash(0) {}
         Entry(ZobristHash hash, Move bestMove, Score score, uint16_t depth, Type type)
             : mHash(hash), mBestMove(bestMove), mScore(score), mDepth(depth), mType(type) {}
-        
+
         bool IsValid() const        { return mHash != 0; }
 
         ZobristHash GetHash() const { return mHash; }
@@ -43,45 +49,81 @@ public:
 
     };
 
-    explicit TranspositionTable(uint8_t log_2_size);
+    explicit TranspositionTable(size_t megabytes);
+    // Drops all entries; not thread-safe
+    void Resize(size_t megabytes);
+    void Clear();
+
     void SetEntry(Entry entry);
-    Entry GetEntry(ZobristHash hash);
+    Entry GetEntry(ZobristHash hash) const;
     void NewSearch();
 
+    size_t GetSize() const { return mMask + 1; }
+
 private:
-    std::vector<Entry> mTable;
-    ZobristHash::HashType mask;
-    uint8_t currentAge;
+    struct Slot {
+        std::atomic<uint64_t> hashXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> mTable;
+    ZobristHash::HashType mMask;
+    std::atomic<uint8_t> mCurrentAge;   // Searches sharing the table may start concurrently
 
-    ZobristHash::HashType IndexOf(ZobristHash hash);
-    bool ShouldOverwrite(Entry oldEntry, Entry newEntry);
+    ZobristHash::HashType IndexOf(ZobristHash hash) const;
+    bool ShouldOverwrite(Entry oldEntry, Entry newEntry) const;
+
+    // Everything but the hash in 64 bits: move, score, depth, type and age
+    static uint64_t Pack(const Entry& entry);
+    static Entry Unpack(ZobristHash hash, uint64_t data);
 
 };
 
 inline void TranspositionTable::SetEntry(Entry entry) {
-    Entry& stored = mTable[IndexOf(entry.GetHash())];
-    if (ShouldOverwrite(stored, entry)) {
-        stored = entry;
-        stored.mAge = currentAge;
+    PROFILE_SCOPE(TableStore);
+    Slot& slot = mTable[IndexOf(entry.GetHash())];
+    uint64_t storedData = slot.data.load(std::memory_order_relaxed);
+    ZobristHash storedHash = slot.hashXorData.load(std::memory_order_relaxed) ^ storedData;
+    if (ShouldOverwrite(Unpack(storedHash, storedData), entry)) {
+        entry.mAge = mCurrentAge.load(std::memory_order_relaxed);
+        uint64_t data = Pack(entry);
+        slot.hashXorData.store(entry.GetHash() ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
     }
 }
 
-inline TranspositionTable::Entry TranspositionTable::GetEntry(ZobristHash hash) {
-    Entry entry = mTable[IndexOf(hash)];
-    if (entry.GetHash() == hash)    return entry;
-    else                            return Entry();
+inline TranspositionTable::Entry TranspositionTable::GetEntry(ZobristHash hash) const {
+    PROFILE_SCOPE(TableProbe);
+    const Slot& slot = mTable[IndexOf(hash)];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.hashXorData.load(std::memory_order_relaxed) ^ data) == hash) return Unpack(hash, data);
+    else                                                                    return Entry();
 }
 
 inline void TranspositionTable::NewSearch() {
-    ++currentAge;
+    mCurrentAge.fetch_add(1, std::memory_order_relaxed);
 }
 
-inline ZobristHash::HashType TranspositionTable::IndexOf(ZobristHash hash) {
-    return hash & mask;
+inline ZobristHash::HashType TranspositionTable::IndexOf(ZobristHash hash) const {
+    return hash & mMask;
 }
 
-inline bool TranspositionTable::ShouldOverwrite(Entry oldEntry, Entry newEntry) {
+inline bool TranspositionTable::ShouldOverwrite(Entry oldEntry, Entry newEntry) const {
     if (oldEntry.GetHash() == 0) return true;
-    if (oldEntry.GetAge() != currentAge) return true;
+    if (oldEntry.GetAge() != mCurrentAge.load(std::memory_order_relaxed)) return true;
     return oldEntry.GetDepth() <= newEntry.GetDepth();
 }
+
+inline uint64_t TranspositionTable::Pack(const Entry& entry) {
+    return  uint64_t(entry.mBestMove.GetRaw())
+        |   uint64_t(uint16_t(entry.mScore)) << 16
+        |   uint64_t(uint8_t(entry.mDepth)) << 32
+        |   uint64_t(entry.mType) << 40
+        |   uint64_t(entry.mAge) << 48;
+}
+
+inline TranspositionTable::Entry TranspositionTable::Unpack(ZobristHash hash, uint64_t data) {
+    Entry entry(hash, Move::FromRaw(uint16_t(data)), Score(uint16_t(data >> 16)), uint8_t(data >> 32), Entry::Type(uint8_t(data >> 40)));
+    entry.mAge = uint8_t(data >> 48);
+    return entry;
+}
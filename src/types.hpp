@@ -294,6 +294,8 @@ constexpr Color operator~(Color color) {
 using Score = int16_t;
 constexpr Score SCORE_MIN = std::numeric_limits<Score>::min() + 1;
 constexpr Score SCORE_MAX = std::numeric_limits<Score>::max();
+// Mate in n plies scores SCORE_MATE - n (see search.hpp)
+constexpr Score SCORE_MATE = 32000;
 
 
 
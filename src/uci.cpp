@@ -0,0 +1,229 @@
+#include "uci.hpp"
+#include "move_list.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Splits off the next space separated token
+static std::string_view NextToken(std::string_view& line) {
+    size_t begin = line.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        line = {};
+        return {};
+    }
+    line.remove_prefix(begin);
+    size_t end = std::min(line.find_first_of(" \t"), line.size());
+    std::string_view token = line.substr(0, end);
+    line.remove_prefix(end);
+    return token;
+}
+
+template <typename T>
+static bool ParseNumber(std::string_view token, T& number) {
+    auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), number);
+    return error == std::errc() && end == token.data() + token.size();
+}
+
+Move ParseUCIMove(const Position& pos, std::string_view uci) {
+    for (Move move : MoveList(pos)) {
+        if (move.ToUCI() == uci) return move;
+    }
+    return Move::NewNone();
+}
+
+UCI::UCI() : mTable(DEFAULT_HASH_MB) {}
+
+UCI::~UCI() {
+    StopSearch();
+}
+
+void UCI::Loop(std::istream& in, std::ostream& out) {
+    mOut = &out;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string_view args = line;
+        std::string_view command = NextToken(args);
+
+        if (command == "uci")               HandleUCI();
+        else if (command == "isready")      Send("readyok");
+        else if (command == "setoption")    HandleSetOption(args);
+        else if (command == "ucinewgame")   { StopSearch(); mTable.Clear(); }
+        else if (command == "position")     HandlePosition(args);
+        else if (command == "go")           HandleGo(args);
+        else if (command == "stop")         StopSearch();
+        else if (command == "quit")         break;
+        else if (!command.empty())          Send("info string unknown command " + std::string(command));
+    }
+    StopSearch();
+}
+
+void UCI::Send(const std::string& line) {
+    std::lock_guard lock(mOutMutex);
+    *mOut << line << std::endl;
+}
+
+void UCI::HandleUCI() {
+    Send("id name chess-engine");
+    Send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(MAX_HASH_MB));
+    Send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+    Send("option name OwnBook type check default false");
+    Send("option name BookFile type string default <empty>");
+    Send("uciok");
+}
+
+// setoption name <id> value <x>
+void UCI::HandleSetOption(std::string_view args) {
+    if (NextToken(args) != "name") return;
+    std::string_view name = NextToken(args);
+    if (NextToken(args) != "value") return;
+    // The rest of the line, file names may contain spaces
+    std::string_view value = args.substr(std::min(args.find_first_not_of(" \t"), args.size()));
+    value = value.substr(0, value.find_last_not_of(" \t\r") + 1);
+
+    StopSearch();
+    if (name == "Hash") {
+        size_t megabytes;
+        if (ParseNumber(value, megabytes) && megabytes >= 1 && megabytes <= MAX_HASH_MB) mTable.Resize(megabytes);
+        else Send("info string invalid Hash value " + std::string(value));
+    }
+    else if (name == "Threads") {
+        int threads;
+        if (ParseNumber(value, threads) && threads >= 1 && threads <= MAX_THREADS) mThreads = threads;
+        else Send("info string invalid Threads value " + std::string(value));
+    }
+    else if (name == "OwnBook") {
+        if (value == "true" || value == "false") mOwnBook = value == "true";
+        else Send("info string invalid OwnBook value " + std::string(value));
+    }
+    else if (name == "BookFile") {
+        mBookFile = value == "<empty>" ? "" : value;
+        LoadBook();
+    }
+    else {
+        Send("info string unknown option " + std::string(name));
+    }
+}
+
+void UCI::LoadBook() {
+    mBook.reset();
+    if (mBookFile.empty()) return;
+    try {
+        mBook = std::make_unique<PolyglotBook>(mBookFile);
+        Send("info string book " + mBookFile + " with " + std::to_string(mBook->GetSize()) + " entries");
+    }
+    catch (const std::exception& e) {
+        Send(std::string("info string cannot load book: ") + e.what());
+    }
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+void UCI::HandlePosition(std::string_view args) {
+    StopSearch();
+
+    std::string_view token = NextToken(args);
+    std::string_view fen;
+    if (token == "startpos") {
+        fen = START_FEN;
+    }
+    else if (token == "fen") {
+        size_t movesBegin = args.find(" moves");
+        fen = args.substr(0, movesBegin);
+        args = movesBegin == std::string_view::npos ? std::string_view() : args.substr(movesBegin);
+    }
+    else {
+        Send("info string expected startpos or fen");
+        return;
+    }
+
+    fen.remove_prefix(std::min(fen.find_first_not_of(" \t"), fen.size()));
+    FenStatus status = mPos.ParseFEN(fen);
+    if (status != FenStatus::Ok) {
+        Send(std::string("info string invalid fen: ") + ToString(status));
+        std::string_view startFen = START_FEN;
+        mPos.ParseFEN(startFen);
+        return;
+    }
+
+    if (NextToken(args) != "moves") return;
+    for (std::string_view uci = NextToken(args); !uci.empty(); uci = NextToken(args)) {
+        Move move = ParseUCIMove(mPos, uci);
+        if (move == Move::NewNone()) {
+            Send("info string illegal move " + std::string(uci));
+            return;
+        }
+        mPos.DoMove(move);
+    }
+}
+
+// go [depth <n>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [infinite]
+void UCI::HandleGo(std::string_view args) {
+    StopSearch();
+
+    SearchLimits limits;
+    for (std::string_view token = NextToken(args); !token.empty(); token = NextToken(args)) {
+        bool valid = true;
+        if (token == "depth")           valid = ParseNumber(NextToken(args), limits.depth);
+        else if (token == "nodes")      valid = ParseNumber(NextToken(args), limits.nodes);
+        else if (token == "movetime")   valid = ParseNumber(NextToken(args), limits.moveTime);
+        else if (token == "wtime")      valid = ParseNumber(NextToken(args), limits.time[ToInt(Color::White)]);
+        else if (token == "btime")      valid = ParseNumber(NextToken(args), limits.time[ToInt(Color::Black)]);
+        else if (token == "winc")       valid = ParseNumber(NextToken(args), limits.increment[ToInt(Color::White)]);
+        else if (token == "binc")       valid = ParseNumber(NextToken(args), limits.increment[ToInt(Color::Black)]);
+        else if (token == "movestogo")  valid = ParseNumber(NextToken(args), limits.movesToGo);
+        else if (token == "infinite")   limits.infinite = true;
+        if (!valid) Send("info string invalid value for " + std::string(token));
+    }
+    limits.depth = std::clamp(limits.depth, 1, MAX_PLY - 1);
+
+    // An infinite search is analysis, which the book would cut short
+    if (mOwnBook && mBook && !limits.infinite) {
+        Move bookMove = mBook->Probe(mPos, mBookRandom);
+        if (bookMove != Move::NewNone()) {
+            Send("info string book move");
+            Send("bestmove " + bookMove.ToUCI());
+            return;
+        }
+    }
+
+    mStop.store(false);
+    mSearchThread = std::thread([this, limits] {
+        SearchResult result = Search(mPos, mTable, limits, mStop, mThreads, [this](const SearchResult& result) {
+            SendInfo(result);
+        });
+        // An infinite search may only report its move after stop, even when the maximal depth is reached
+        if (limits.infinite) mStop.wait(false);
+
+        std::string bestMove = "bestmove " + result.bestMove.ToUCI();
+        if (result.pv.size() > 1 && result.pv[0] == result.bestMove) bestMove += " ponder " + result.pv[1].ToUCI();
+        Send(bestMove);
+    });
+}
+
+// Also called before every command that changes the state of the search: waiting for the search instead
+// would block the input thread until it ends, forever for an infinite one
+void UCI::StopSearch() {
+    mStop.store(true);
+    mStop.notify_all();
+    if (mSearchThread.joinable()) mSearchThread.join();
+}
+
+void UCI::SendInfo(const SearchResult& result) {
+    std::ostringstream info;
+    info << "info depth " << result.depth << " score ";
+    if (IsMateScore(result.score)) {
+        info << "mate " << MateInMoves(result.score);
+    } else {
+        info << "cp " << result.score;
+    }
+    info << " nodes " << result.nodes
+         << " nps " << result.nodes * 1000 / std::max<int64_t>(result.time, 1)
+         << " time " << result.time
+         << " pv";
+    for (Move move : result.pv) info << ' ' << move.ToUCI();
+    Send(info.str());
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "polyglot_book.hpp"
+#include "position.hpp"
+#include "search.hpp"
+#include "transposition_table.hpp"
+
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Matches a move in long algebraic notation against the legal moves; Move::NewNone() if none matches
+Move ParseUCIMove(const Position& pos, std::string_view uci);
+
+/**
+ * UCI protocol loop, see https://www.chessprogramming.org/UCI
+ * Searches run on their own thread so that the input thread stays responsive; stop sets a flag
+ * that the search polls on every node
+ */
+class UCI {
+public:
+    static constexpr size_t DEFAULT_HASH_MB = 16;
+    static constexpr size_t MAX_HASH_MB     = 65536;
+    static constexpr int MAX_THREADS        = 256;
+
+    UCI();
+    ~UCI();
+
+    // Returns on quit or at the end of the input
+    void Loop(std::istream& in, std::ostream& out);
+
+private:
+    Position mPos;
+    TranspositionTable mTable;
+    int mThreads = 1;
+
+    // Book moves are played without searching while OwnBook is set and a book is loaded
+    bool mOwnBook = false;
+    std::string mBookFile;
+    std::unique_ptr<PolyglotBook> mBook;
+    std::mt19937_64 mBookRandom{ std::random_device()() };
+
+    std::thread mSearchThread;
+    std::atomic<bool> mStop = false;
+
+    std::ostream* mOut = nullptr;
+    std::mutex mOutMutex;
+
+    void Send(const std::string& line);
+
+    void HandleUCI();
+    void HandleSetOption(std::string_view args);
+    void HandlePosition(std::string_view args);
+    void HandleGo(std::string_view args);
+
+    void LoadBook();
+
+    void StopSearch();
+
+    void SendInfo(const SearchResult& result);
+
+};
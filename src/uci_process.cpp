@@ -0,0 +1,139 @@
+#include "uci_process.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using Clock = std::chrono::steady_clock;
+
+UciProcess::UciProcess(const std::string& command) : mName(command) {
+    std::vector<std::string> args;
+    std::istringstream words(command);
+    for (std::string word; words >> word; ) args.push_back(word);
+    if (args.empty()) throw std::runtime_error("Empty engine command");
+    std::vector<char*> argv;
+    for (std::string& arg : args) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    // Close-on-exec keeps the pipes of other engines, started concurrently, out of this child
+    int toEngine[2], fromEngine[2];
+    if (pipe2(toEngine, O_CLOEXEC) != 0) throw std::runtime_error("Cannot create pipe");
+    if (pipe2(fromEngine, O_CLOEXEC) != 0) {
+        close(toEngine[0]);
+        close(toEngine[1]);
+        throw std::runtime_error("Cannot create pipe");
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, toEngine[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fromEngine[1], STDOUT_FILENO);
+    int error = posix_spawnp(&mPid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    close(toEngine[0]);
+    close(fromEngine[1]);
+    mIn = toEngine[1];
+    mOut = fromEngine[0];
+    if (error != 0) {
+        close(mIn);
+        close(mOut);
+        throw std::runtime_error("Cannot start engine: " + command);
+    }
+
+    Send("uci");
+    std::string line;
+    auto deadline = Clock::now() + std::chrono::milliseconds(STARTUP_TIMEOUT);
+    while (true) {
+        int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (!ReadLine(line, std::max<int64_t>(left, 0))) {
+            // The destructor does not run for a throwing constructor
+            kill(mPid, SIGKILL);
+            waitpid(mPid, nullptr, 0);
+            close(mIn);
+            close(mOut);
+            throw std::runtime_error("No uciok from engine: " + command);
+        }
+        if (line == "uciok") break;
+        if (line.rfind("id name ", 0) == 0) mName = line.substr(8);
+    }
+}
+
+UciProcess::~UciProcess() {
+    if (mPid > 0) {
+        Send("quit");
+        close(mIn);
+        // Give the engine a moment to exit on its own
+        for (int i = 0; i < 100 && waitpid(mPid, nullptr, WNOHANG) == 0; ++i) usleep(10000);
+        if (waitpid(mPid, nullptr, WNOHANG) == 0) {
+            kill(mPid, SIGKILL);
+            waitpid(mPid, nullptr, 0);
+        }
+    }
+    else if (mIn >= 0) {
+        close(mIn);
+    }
+    if (mOut >= 0) close(mOut);
+}
+
+bool UciProcess::Send(const std::string& line) {
+    std::string data = line + '\n';
+    for (size_t written = 0; written < data.size(); ) {
+        ssize_t count = write(mIn, data.data() + written, data.size() - written);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        written += count;
+    }
+    return true;
+}
+
+bool UciProcess::ReadLine(std::string& line, int64_t timeout) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout);
+    while (true) {
+        size_t newline = mBuffer.find('\n');
+        if (newline != std::string::npos) {
+            line.assign(mBuffer, 0, newline);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            mBuffer.erase(0, newline + 1);
+            return true;
+        }
+
+        int wait = -1;
+        if (timeout >= 0) {
+            int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left < 0) return false;
+            wait = int(std::min<int64_t>(left, 1 << 30));
+        }
+        pollfd descriptor = { mOut, POLLIN, 0 };
+        int ready = poll(&descriptor, 1, wait);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+
+        char chunk[4096];
+        ssize_t count = read(mOut, chunk, sizeof(chunk));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        mBuffer.append(chunk, count);
+    }
+}
+
+bool UciProcess::WaitReady(int64_t timeout) {
+    if (!Send("isready")) return false;
+    std::string line;
+    while (ReadLine(line, timeout)) {
+        if (line == "readyok") return true;
+    }
+    return false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+/**
+ * A UCI engine running as a child process, talked to over pipes
+ * Requires a POSIX system. The caller should ignore SIGPIPE so that a crashed engine shows up as a
+ * failed read instead of ending the program
+ */
+class UciProcess {
+public:
+    // Runs the command (split at spaces, looked up in PATH) and waits for uciok; throws on failure
+    explicit UciProcess(const std::string& command);
+    ~UciProcess();
+
+    UciProcess(const UciProcess&) = delete;
+    UciProcess& operator=(const UciProcess&) = delete;
+
+    // Returns false if the engine is gone
+    bool Send(const std::string& line);
+    // Returns false at the end of the output or when nothing arrives within timeout ms (< 0: no timeout)
+    bool ReadLine(std::string& line, int64_t timeout);
+    // Sends isready and waits for readyok
+    bool WaitReady(int64_t timeout);
+
+    // The engine name from "id name", or the command
+    const std::string& GetName() const  { return mName; }
+
+private:
+    static constexpr int64_t STARTUP_TIMEOUT = 10000;  // ms
+
+    pid_t mPid = -1;
+    int mIn = -1;       // Engine stdin
+    int mOut = -1;      // Engine stdout
+    std::string mBuffer;
+    std::string mName;
+
+};
@@ -1,33 +1,54 @@
 #include "zobrist_hash.hpp"
 
-#include <random>
+// Deterministic key stream, see https://prng.di.unimi.it/splitmix64.c
+class SplitMix64 {
+public:
+    constexpr explicit SplitMix64(uint64_t seed) : mState(seed) {}
+
+    constexpr uint64_t Next() {
+        uint64_t z = (mState += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
 
-bool ZobristHash::initialized = false;
+private:
+    uint64_t mState;
+};
 
-Array2D<ZobristHash::HashType, SQUARE_NUM, PIECE_NUM> ZobristHash::pieces;
-ZobristHash::HashType                                 ZobristHash::sideToMove;
-Array<ZobristHash::HashType, CASTLING_RIGHTS_NUM>     ZobristHash::castlingRights;
-Array<ZobristHash::HashType, BOARD_FILE_NUM>          ZobristHash::enPassantFile;
+struct ZobristKeys {
+    Array2D<ZobristHash::HashType, SQUARE_NUM, PIECE_NUM> pieces;
+    ZobristHash::HashType                                 sideToMove;
+    Array<ZobristHash::HashType, CASTLING_RIGHTS_NUM>     castlingRights;
+    Array<ZobristHash::HashType, BOARD_FILE_NUM>          enPassantFile;
+};
 
-void ZobristHash::Init(uint64_t seed) {
-    std::mt19937_64 mt(seed);
-    std::uniform_int_distribution<HashType> udist(0, std::numeric_limits<HashType>::max());
+static constexpr ZobristKeys ComputeKeys() {
+    SplitMix64 rng(0);
+    ZobristKeys keys = {};
 
-    for (auto& piecesOfSquare : pieces) {
+    for (auto& piecesOfSquare : keys.pieces) {
         for (auto& piece : piecesOfSquare) {
-            piece = udist(mt);
+            piece = rng.Next();
         }
     }
 
-    sideToMove = udist(mt);
+    keys.sideToMove = rng.Next();
 
-    for (auto& castlingRight : castlingRights) {
-        castlingRight = udist(mt);
+    for (auto& castlingRight : keys.castlingRights) {
+        castlingRight = rng.Next();
     }
 
-    for (auto& enPassant : enPassantFile) {
-        enPassant = udist(mt);
+    for (auto& enPassant : keys.enPassantFile) {
+        enPassant = rng.Next();
     }
 
-    initialized = true;
-}
\ No newline at end of file
+    return keys;
+}
+
+static constexpr ZobristKeys Keys = ComputeKeys();
+
+constinit const Array2D<ZobristHash::HashType, SQUARE_NUM, PIECE_NUM> ZobristHash::pieces = Keys.pieces;
+constinit const ZobristHash::HashType                                 ZobristHash::sideToMove = Keys.sideToMove;
+constinit const Array<ZobristHash::HashType, CASTLING_RIGHTS_NUM>     ZobristHash::castlingRights = Keys.castlingRights;
+constinit const Array<ZobristHash::HashType, BOARD_FILE_NUM>          ZobristHash::enPassantFile = Keys.enPassantFile;
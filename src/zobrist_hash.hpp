@@ -12,9 +12,7 @@ class ZobristHash {
 public:
     using HashType = uint64_t;
 
-    static void Init(uint64_t seed = 0);
-
-    ZobristHash() { assert(initialized); }
+    ZobristHash() = default;
     ZobristHash(HashType hash) { mHash = hash; }
 
     void SwitchPiece(Square square, Piece piece);
@@ -24,12 +22,11 @@ public:
     operator HashType() const;
 
 private:
-    static bool initialized;
-
-    static Array2D<HashType, SQUARE_NUM, PIECE_NUM> pieces;
-    static HashType                                 sideToMove;
-    static Array<HashType, CASTLING_RIGHTS_NUM>     castlingRights;
-    static Array<HashType, BOARD_FILE_NUM>          enPassantFile;
+    // Keys are generated at compile time (see zobrist_hash.cpp)
+    static const Array2D<HashType, SQUARE_NUM, PIECE_NUM> pieces;
+    static const HashType                                 sideToMove;
+    static const Array<HashType, CASTLING_RIGHTS_NUM>     castlingRights;
+    static const Array<HashType, BOARD_FILE_NUM>          enPassantFile;
 
     HashType mHash = 0;
 